@@ -0,0 +1,115 @@
+/**
+ * AnswerTrie.cpp
+ * Christopher Chute
+ *
+ * Remaining answers as a trie of their prefixes, for counting the
+ * responses to a guess without comparing every answer from scratch.
+ */
+
+#include <algorithm>
+#include "AnswerTrie.h"
+#include "PerfectMatchingUniverse.h"
+
+#define LAST_NODE_DEPTH (PERM_LENGTH - 2) // Deepest node; the last digit is implied.
+
+using std::fill;
+using std::sort;
+using std::vector;
+
+typedef PerfectMatching Pm;
+typedef PerfectMatchingRank PmRank;
+
+AnswerTrie::AnswerTrie(const PerfectMatchingSet* answers) :
+        nodes(new vector<Node>()),
+        numAnswers(answers->size())
+{
+    vector<PmRank> ranks;
+    ranks.reserve(answers->size());
+    for (PerfectMatchingSet::const_iterator it = answers->begin(); it != answers->end(); ++it) {
+        ranks.push_back(it.rank());
+    }
+    this->build(&ranks);
+}
+
+AnswerTrie::AnswerTrie(const vector<PmRank>& answers) :
+        nodes(new vector<Node>()),
+        numAnswers(answers.size())
+{
+    vector<PmRank> ranks(answers);
+    this->build(&ranks);
+}
+
+AnswerTrie::~AnswerTrie() {
+    delete this->nodes;
+}
+
+void AnswerTrie::build(vector<PmRank>* ranks) {
+    // Lexicographic order puts answers with a common prefix next to each other.
+    sort(ranks->begin(), ranks->end());
+
+    const PerfectMatchingUniverse& universe = PerfectMatchingUniverse::get();
+    size_t openNodes[LAST_NODE_DEPTH + 1];  // Node at each depth on the current path.
+    const Pm* previous = nullptr;
+    for (vector<PmRank>::const_iterator it = ranks->begin(); it != ranks->end(); ++it) {
+        const Pm& answer = universe.at(*it);
+        int numShared = 0;
+        while (previous && numShared <= LAST_NODE_DEPTH &&
+               (*previous)[numShared] == answer[numShared]) {
+            ++numShared;
+        }
+
+        // Close the subtrees this answer leaves, then open its own nodes.
+        for (int depth = numShared; previous && depth <= LAST_NODE_DEPTH; ++depth) {
+            (*this->nodes)[openNodes[depth]].end = uint32_t(this->nodes->size());
+        }
+        uint16_t usedDigits = 0;
+        for (int depth = 0; depth <= LAST_NODE_DEPTH; ++depth) {
+            usedDigits |= uint16_t(1 << (answer[depth] - '0'));
+            if (depth >= numShared) {
+                Node node = { usedDigits, uint8_t(depth), uint8_t(answer[depth] - '0'), 0, 0 };
+                openNodes[depth] = this->nodes->size();
+                this->nodes->push_back(node);
+            }
+            ++(*this->nodes)[openNodes[depth]].numAnswers;
+        }
+        previous = &answer;
+    }
+    for (int depth = 0; previous && depth <= LAST_NODE_DEPTH; ++depth) {
+        (*this->nodes)[openNodes[depth]].end = uint32_t(this->nodes->size());
+    }
+}
+
+void AnswerTrie::countResponses(const Pm& guess, int* numGivenResponse) const {
+    // Digits of the guess, and the set of its digits after each position.
+    int guessDigits[PERM_LENGTH];
+    uint16_t laterDigits[PERM_LENGTH];
+    for (int i = 0; i < PERM_LENGTH; ++i) {
+        guessDigits[i] = guess[i] - '0';
+    }
+    laterDigits[PERM_LENGTH - 1] = 0;
+    for (int i = PERM_LENGTH - 2; i >= 0; --i) {
+        laterDigits[i] = uint16_t(laterDigits[i + 1] | (1 << guessDigits[i + 1]));
+    }
+    fill(numGivenResponse, numGivenResponse + PERM_LENGTH + 1, 0);
+
+    // Number correct in the positions above each depth of the current path.
+    int numCorrectAbove[LAST_NODE_DEPTH + 1];
+    numCorrectAbove[0] = 0;
+    const Node* begin = this->nodes->data();
+    const Node* end = begin + this->nodes->size();
+    for (const Node* node = begin; node != end; ) {
+        int numCorrect = numCorrectAbove[node->depth] + (node->digit == guessDigits[node->depth]);
+        if (!(laterDigits[node->depth] & ~node->usedDigits)) {
+            // Every later digit of the guess is placed already: no more agree.
+            numGivenResponse[numCorrect] += int(node->numAnswers);
+            node = begin + node->end;
+        } else if (node->depth == LAST_NODE_DEPTH) {
+            // The one digit left, at the last position, is the guess's.
+            numGivenResponse[numCorrect + 1] += int(node->numAnswers);
+            ++node;
+        } else {
+            numCorrectAbove[node->depth + 1] = numCorrect;
+            ++node;
+        }
+    }
+}
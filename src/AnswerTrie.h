@@ -0,0 +1,70 @@
+/**
+ * AnswerTrie.h
+ * Christopher Chute
+ *
+ * Remaining answers as a trie of their prefixes, for counting the
+ * responses to a guess without comparing every answer from scratch.
+ */
+
+#ifndef GUARD_ANSWER_TRIE_H
+#define GUARD_ANSWER_TRIE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "PerfectMatching.h"
+#include "PerfectMatchingSet.h"
+
+/**
+ * Answers sorted and laid out as the nodes of a trie in depth-first order.
+ * A node stands for a prefix shared by one or more answers, so a guess is
+ * compared with each shared position once rather than once per answer.
+ * The last position of a permutation follows from the others, so the
+ * deepest nodes are at position PERM_LENGTH - 2 and stand for one answer.
+ */
+class AnswerTrie {
+private:
+    struct Node {
+        uint16_t usedDigits;   // Digits at positions 0 through depth, as bits.
+        uint8_t depth;         // Position of this node's digit.
+        uint8_t digit;         // Digit at that position.
+        uint32_t end;          // Index of the first node after this subtree.
+        uint32_t numAnswers;   // Answers with this prefix.
+    };
+    std::vector<Node>* nodes;
+    size_t numAnswers;
+
+    AnswerTrie(const AnswerTrie&) = delete;
+    AnswerTrie& operator=(const AnswerTrie&) = delete;
+
+    void build(std::vector<PerfectMatchingRank>* ranks);
+public:
+    /**
+     * Build the trie of a set of answers.
+     * @param answers Answers to build from, in any order.
+     */
+    explicit AnswerTrie(const PerfectMatchingSet* answers);
+
+    /**
+     * Build the trie of a list of answers.
+     * @param answers Ranks of the answers to build from, in any order.
+     */
+    explicit AnswerTrie(const std::vector<PerfectMatchingRank>& answers);
+    ~AnswerTrie();
+
+    /**
+     * Count the answers giving each response to a guess, i.e., the same
+     * histogram as calling numInCommon on every answer. A subtree whose
+     * later positions can't agree with the guess, since the guess's digits
+     * there are all used in the prefix, is counted without visiting it.
+     * @param guess Perfect Matching guess.
+     * @param numGivenResponse Set to the number of answers with each number
+     * correct, PERM_LENGTH + 1 entries.
+     */
+    void countResponses(const PerfectMatching& guess, int* numGivenResponse) const;
+
+    size_t getNumAnswers() const { return this->numAnswers; }
+    size_t getNumNodes() const { return this->nodes->size(); }
+};
+
+#endif
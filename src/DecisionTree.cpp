@@ -0,0 +1,160 @@
+/**
+ * DecisionTree.cpp
+ * Christopher Chute
+ *
+ * Moves chosen ahead of time for particular sets of remaining answers.
+ */
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <limits>
+#include <sstream>
+#include "DecisionTree.h"
+#include "PerfectMatchingSet.h"
+
+#define TREE_FORMAT ("ayto-tree-2")     // First line of every tree file.
+#define OLD_TREE_FORMAT ("ayto-tree-1") // Tree files without the largest state size.
+
+using std::ifstream;
+using std::istringstream;
+using std::map;
+using std::ofstream;
+using std::string;
+
+typedef PerfectMatching Pm;
+typedef TruthBooth Tb;
+
+DecisionTree::DecisionTree() :
+        truthBooths(new map<uint64_t, Tb>()),
+        perfectMatchings(new map<uint64_t, Pm>()),
+        maxNumAnswers(0)
+{}
+
+DecisionTree::DecisionTree(const DecisionTree& that) :
+        truthBooths(new map<uint64_t, Tb>(*that.truthBooths)),
+        perfectMatchings(new map<uint64_t, Pm>(*that.perfectMatchings)),
+        maxNumAnswers(that.maxNumAnswers)
+{}
+
+DecisionTree& DecisionTree::operator=(const DecisionTree& that) {
+    if (this != &that) {
+        *this->truthBooths = *that.truthBooths;
+        *this->perfectMatchings = *that.perfectMatchings;
+        this->maxNumAnswers = that.maxNumAnswers;
+    }
+    return *this;
+}
+
+DecisionTree::~DecisionTree() {
+    delete this->truthBooths;
+    delete this->perfectMatchings;
+}
+
+void DecisionTree::addTruthBooth(uint64_t key, size_t numAnswers, const Tb& truthBooth) {
+    (*this->truthBooths)[key] = truthBooth;
+    this->maxNumAnswers = std::max(this->maxNumAnswers, numAnswers);
+}
+
+void DecisionTree::addPerfectMatching(uint64_t key, size_t numAnswers, const Pm& perfectMatching) {
+    (*this->perfectMatchings)[key] = perfectMatching;
+    this->maxNumAnswers = std::max(this->maxNumAnswers, numAnswers);
+}
+
+bool DecisionTree::findTruthBooth(const PerfectMatchingSet* possibleAnswers, Tb* truthBooth) const {
+    if (possibleAnswers->size() > this->maxNumAnswers) {
+        return false;
+    }
+    map<uint64_t, Tb>::const_iterator it = this->truthBooths->find(possibleAnswers->hash());
+    if (it == this->truthBooths->end()) {
+        return false;
+    }
+    *truthBooth = it->second;
+    return true;
+}
+
+bool DecisionTree::findPerfectMatching(const PerfectMatchingSet* possibleAnswers,
+                                       Pm* perfectMatching) const {
+    if (possibleAnswers->size() > this->maxNumAnswers) {
+        return false;
+    }
+    map<uint64_t, Pm>::const_iterator it =
+            this->perfectMatchings->find(possibleAnswers->hash());
+    if (it == this->perfectMatchings->end()) {
+        return false;
+    }
+    *perfectMatching = it->second;
+    return true;
+}
+
+size_t DecisionTree::size() const {
+    return this->truthBooths->size() + this->perfectMatchings->size();
+}
+
+bool DecisionTree::saveToFile(const string& filename) const {
+    string tmpFilename = filename + ".tmp";
+    ofstream outputFile(tmpFilename);
+    if (!outputFile) {
+        return false;
+    }
+
+    outputFile << TREE_FORMAT << "\n" << std::hex;
+    outputFile << "max " << this->maxNumAnswers << "\n";
+    for (map<uint64_t, Tb>::const_iterator it = this->truthBooths->begin();
+         it != this->truthBooths->end();
+         ++it) {
+        outputFile << "tb " << it->first << " " << it->second.toString() << "\n";
+    }
+    for (map<uint64_t, Pm>::const_iterator it = this->perfectMatchings->begin();
+         it != this->perfectMatchings->end();
+         ++it) {
+        outputFile << "pm " << it->first << " " << it->second << "\n";
+    }
+    outputFile.close();
+    if (!outputFile) {
+        return false;
+    }
+
+    return std::rename(tmpFilename.c_str(), filename.c_str()) == 0;
+}
+
+bool DecisionTree::loadFromFile(const string& filename) {
+    ifstream inputFile(filename);
+    string line;
+    if (!getline(inputFile, line) || (line != TREE_FORMAT && line != OLD_TREE_FORMAT)) {
+        return false;
+    }
+    if (line == OLD_TREE_FORMAT) {
+        this->maxNumAnswers = std::numeric_limits<size_t>::max();
+    }
+
+    while (getline(inputFile, line)) {
+        istringstream fields(line);
+        string kind;
+        uint64_t key;
+        string move;
+        if (!(fields >> kind)) {
+            continue;
+        }
+        if (kind == "max") {
+            size_t numAnswers;
+            if (!(fields >> std::hex >> numAnswers)) {
+                return false;
+            }
+            this->maxNumAnswers = std::max(this->maxNumAnswers, numAnswers);
+            continue;
+        }
+        if (!(fields >> std::hex >> key >> move)) {
+            return false;
+        }
+        if (kind == "tb" && move.size() == 2 &&
+                move[0] >= '0' && move[0] <= '9' && move[1] >= '0' && move[1] <= '9') {
+            (*this->truthBooths)[key] = Tb(move[0] - '0', move[1]);
+        } else if (kind == "pm" && isPerfectMatching(move)) {
+            (*this->perfectMatchings)[key] = move;
+        } else {
+            return false;
+        }
+    }
+    return true;
+}
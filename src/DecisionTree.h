@@ -0,0 +1,90 @@
+/**
+ * DecisionTree.h
+ * Christopher Chute
+ *
+ * Moves chosen ahead of time for particular sets of remaining answers, e.g.,
+ * by the optimal solver. A game consults the tree before running its own
+ * strategy, and falls back to that strategy in states the tree lacks.
+ */
+
+#ifndef GUARD_DECISION_TREE_H
+#define GUARD_DECISION_TREE_H
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include "PerfectMatching.h"
+#include "TruthBooth.h"
+
+class PerfectMatchingSet;
+
+class DecisionTree {
+private:
+    std::map<uint64_t, TruthBooth>* truthBooths;           // Keyed by hash of answers.
+    std::map<uint64_t, PerfectMatching>* perfectMatchings; // Keyed by hash of answers.
+    size_t maxNumAnswers;    // Answers in the largest state with a move.
+public:
+    DecisionTree();
+    DecisionTree(const DecisionTree& that);
+    DecisionTree& operator=(const DecisionTree& that);
+    ~DecisionTree();
+
+    /**
+     * Set the Truth Booth to submit at the start of a week.
+     * @param key PerfectMatchingSet::hash of the remaining answers.
+     * @param numAnswers Number of remaining answers.
+     * @param truthBooth Truth Booth to submit.
+     */
+    void addTruthBooth(uint64_t key, size_t numAnswers, const TruthBooth& truthBooth);
+
+    /**
+     * Set the Perfect Matching to submit after the Truth Booth.
+     * @param key PerfectMatchingSet::hash of the remaining answers.
+     * @param numAnswers Number of remaining answers.
+     * @param perfectMatching Perfect Matching to submit.
+     */
+    void addPerfectMatching(uint64_t key, size_t numAnswers, const PerfectMatching& perfectMatching);
+
+    /**
+     * Look up the Truth Booth for a state. States larger than any in the
+     * tree are not hashed.
+     * @param possibleAnswers Remaining answers.
+     * @param truthBooth Where the Truth Booth goes, if found.
+     * @return True if the tree has a Truth Booth for the state.
+     */
+    bool findTruthBooth(const PerfectMatchingSet* possibleAnswers, TruthBooth* truthBooth) const;
+
+    /**
+     * Look up the Perfect Matching for a state. States larger than any in
+     * the tree are not hashed.
+     * @param possibleAnswers Remaining answers.
+     * @param perfectMatching Where the Perfect Matching goes, if found.
+     * @return True if the tree has a Perfect Matching for the state.
+     */
+    bool findPerfectMatching(const PerfectMatchingSet* possibleAnswers,
+                             PerfectMatching* perfectMatching) const;
+
+    /**
+     * Get the number of states with a move.
+     * @return Number of Truth Booth and Perfect Matching moves in the tree.
+     */
+    size_t size() const;
+
+    /**
+     * Write the tree to a file, through a temporary file so that an
+     * interrupted write never leaves a truncated tree behind.
+     * @param filename Path of the tree file.
+     * @return True if the file was written, false otherwise.
+     */
+    bool saveToFile(const std::string& filename) const;
+
+    /**
+     * Add the moves in a file written by saveToFile. A file from before
+     * state sizes were saved is looked up in states of every size.
+     * @param filename Path of the tree file.
+     * @return True if the file was read, false if missing or malformed.
+     */
+    bool loadFromFile(const std::string& filename);
+};
+
+#endif
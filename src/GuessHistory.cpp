@@ -0,0 +1,24 @@
+/**
+ * GuessHistory.cpp
+ * Christopher Chute
+ *
+ * Perfect Matching guesses made so far, indexed by rank for minimax.
+ */
+
+#include "GuessHistory.h"
+
+using std::vector;
+
+GuessHistory::GuessHistory(const PerfectMatchingSet* guessesAlreadyMade) :
+        isGuessed(new vector<uint64_t>(NUM_BITSET_WORDS, 0))
+{
+    for (PerfectMatchingSet::const_iterator it = guessesAlreadyMade->begin();
+         it != guessesAlreadyMade->end();
+         ++it) {
+        (*this->isGuessed)[it.rank() / 64] |= 1ULL << (it.rank() % 64);
+    }
+}
+
+GuessHistory::~GuessHistory() {
+    delete this->isGuessed;
+}
@@ -0,0 +1,47 @@
+/**
+ * GuessHistory.h
+ * Christopher Chute
+ *
+ * Perfect Matching guesses made so far, indexed by rank for minimax.
+ */
+
+#ifndef GUARD_GUESS_HISTORY_H
+#define GUARD_GUESS_HISTORY_H
+
+#include <cstdint>
+#include <vector>
+#include "PerfectMatching.h"
+#include "PerfectMatchingSet.h"
+
+/**
+ * Read-only index of the Perfect Matching guesses made so far, with a bit
+ * per rank. Built once per decision and shared by the threads scoring
+ * candidates, which look each candidate up by the rank their iterator
+ * already holds instead of comparing strings against every past guess.
+ * Past Truth Booths are kept the same way inside TruthBoothSet.
+ */
+class GuessHistory {
+private:
+    std::vector<uint64_t>* isGuessed; // Bit r is set if rank r was guessed.
+
+    GuessHistory(const GuessHistory&) = delete;
+    GuessHistory& operator=(const GuessHistory&) = delete;
+public:
+    /**
+     * Index a set of guesses.
+     * @param guessesAlreadyMade Perfect Matchings submitted so far.
+     */
+    explicit GuessHistory(const PerfectMatchingSet* guessesAlreadyMade);
+    ~GuessHistory();
+
+    /**
+     * Check whether a Perfect Matching was guessed already.
+     * @param rank Rank of the Perfect Matching.
+     * @return True if it is among the guesses made so far.
+     */
+    bool contains(PerfectMatchingRank rank) const {
+        return ((*this->isGuessed)[rank / 64] >> (rank % 64)) & 1;
+    }
+};
+
+#endif
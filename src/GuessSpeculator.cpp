@@ -0,0 +1,295 @@
+/**
+ * GuessSpeculator.cpp
+ * Christopher Chute
+ *
+ * Compute guesses in the background while interactive mode waits for the
+ * player's feedback.
+ */
+
+#include <algorithm>
+#include "GuessSpeculator.h"
+
+using std::deque;
+using std::mutex;
+using std::sort;
+using std::thread;
+using std::unique_lock;
+using std::vector;
+
+// Larger states first: they are the likelier feedback.
+static bool isLarger(const PmSet* a, const PmSet* b) {
+    return a->size() > b->size();
+}
+
+GuessSpeculator::GuessSpeculator(const MinimaxCostModel* c,
+                                 const ScoringPolicies& s,
+                                 const DecisionTree* t,
+                                 bool l) :
+        costModel(c),
+        scoringPolicies(s),
+        decisionTree(t),
+        isLookahead(l),
+        running(nullptr),
+        isStopping(false)
+{
+    this->worker = thread(&GuessSpeculator::run, this);
+}
+
+GuessSpeculator::~GuessSpeculator() {
+    {
+        unique_lock<mutex> guard(this->lock);
+        this->isStopping = true;
+        if (this->running) {
+            this->running->isCancelled = true;
+        }
+        this->changed.notify_all();
+    }
+    this->worker.join();
+    for (vector<Job*>::iterator it = this->jobs.begin(); it != this->jobs.end(); ++it) {
+        delete *it;
+    }
+}
+
+uint64_t GuessSpeculator::getKey(const PmSet* possibleAnswers, const PmSet* pmGuessesAlreadyMade) {
+    // The answers, then the number of guesses made.
+    return (possibleAnswers->hash() ^ pmGuessesAlreadyMade->size()) * 1099511628211ULL;
+}
+
+GuessSpeculator::Job* GuessSpeculator::findJob(const PmSet* possibleAnswers,
+                                                const PmSet* pmGuessesAlreadyMade) const {
+    // Hash the state only once a job with as many answers turns up.
+    uint64_t key = 0;
+    bool isHashed = false;
+    for (vector<Job*>::const_iterator it = this->jobs.begin(); it != this->jobs.end(); ++it) {
+        if ((*it)->isCancelled || (*it)->possibleAnswers->size() != possibleAnswers->size()) {
+            continue;
+        }
+        if (!isHashed) {
+            key = getKey(possibleAnswers, pmGuessesAlreadyMade);
+            isHashed = true;
+        }
+        if ((*it)->key == key) {
+            return *it;
+        }
+    }
+    return nullptr;
+}
+
+void GuessSpeculator::removeJob(Job* job) {
+    deque<Job*>::iterator queued = std::find(this->queue.begin(), this->queue.end(), job);
+    if (queued != this->queue.end()) {
+        this->queue.erase(queued);
+    }
+    this->jobs.erase(std::find(this->jobs.begin(), this->jobs.end(), job));
+    delete job;
+}
+
+void GuessSpeculator::addPerfectMatchingJobs(const PmSet* possibleAnswers,
+                                             const Tb& tbGuess,
+                                             const PmSet* pmGuessesAlreadyMade) {
+    vector<PmSet*> states;
+    for (int isMatch = 0; isMatch <= 1; ++isMatch) {
+        PmSet* state = new PmSet(possibleAnswers->begin(), possibleAnswers->end());
+        state->filter(tbGuess, isMatch == 1);
+        Pm treeGuess;
+        if (this->decisionTree &&
+                this->decisionTree->findPerfectMatching(state, &treeGuess)) {
+            delete state; // The tree has the guess already.
+            continue;
+        }
+        states.push_back(state);
+    }
+    sort(states.begin(), states.end(), isLarger);
+
+    // Push the smaller state first, so the larger one ends up in front.
+    unique_lock<mutex> guard(this->lock);
+    for (vector<PmSet*>::reverse_iterator it = states.rbegin(); it != states.rend(); ++it) {
+        if ((*it)->size() == 0 || findJob(*it, pmGuessesAlreadyMade)) {
+            delete *it;
+            continue;
+        }
+        Job* job = new Job();
+        job->possibleAnswers = *it;
+        job->pmGuessesAlreadyMade = new PmSet(pmGuessesAlreadyMade->begin(),
+                                              pmGuessesAlreadyMade->end());
+        job->key = getKey(*it, pmGuessesAlreadyMade);
+        this->jobs.push_back(job);
+        this->queue.push_front(job);
+    }
+    this->changed.notify_all();
+}
+
+void GuessSpeculator::run() {
+    unique_lock<mutex> guard(this->lock);
+    while (true) {
+        while (!this->isStopping && this->queue.empty()) {
+            this->changed.wait(guard);
+        }
+        if (this->isStopping) {
+            return;
+        }
+        Job* job = this->queue.front();
+        this->queue.pop_front();
+        this->running = job;
+        guard.unlock();
+
+        Pm guess;
+        Tb tbGuess;
+        if (job->isWholeWeek) {
+            // The week's booth comes from the tree, else lookahead or the greedy choice.
+            bool isTbInTree = this->decisionTree &&
+                    this->decisionTree->findTruthBooth(job->possibleAnswers, &tbGuess);
+            bool isLookaheadWeek = !isTbInTree && this->isLookahead &&
+                    job->possibleAnswers->size() > 1;
+            if (!isTbInTree && !isLookaheadWeek) {
+                TbSet tbGuessesAlreadyMade;
+                for (vector<Tb>::const_iterator it = job->tbGuessesAlreadyMade.begin();
+                     it != job->tbGuessesAlreadyMade.end();
+                     ++it) {
+                    tbGuessesAlreadyMade.add(*it);
+                }
+                tbGuess = getNextTruthBoothGuess(job->possibleAnswers, &tbGuessesAlreadyMade);
+            }
+            // Lookahead picks both guesses with the booth, so there is nothing to plan.
+            if (!job->isCancelled && !isLookaheadWeek) {
+                this->addPerfectMatchingJobs(job->possibleAnswers,
+                                             tbGuess,
+                                             job->pmGuessesAlreadyMade);
+            }
+        } else {
+            MinimaxOptions options;
+            options._costModel = this->costModel;
+            options._scoringPolicies = this->scoringPolicies;
+            options._isCancelled = &job->isCancelled;
+            guess = getNextPerfectMatchingGuess(job->possibleAnswers,
+                                                job->pmGuessesAlreadyMade,
+                                                options);
+        }
+
+        guard.lock();
+        this->running = nullptr;
+        if (job->isWholeWeek || job->isCancelled) {
+            this->removeJob(job);
+        } else {
+            job->guess = guess;
+            job->isDone = true;
+        }
+        this->changed.notify_all();
+    }
+}
+
+void GuessSpeculator::speculateTruthBooth(const PmSet* possibleAnswers,
+                                          const Tb& tbGuess,
+                                          const PmSet* pmGuessesAlreadyMade) {
+    if (pmGuessesAlreadyMade->size() < 2) {
+        return; // The first two guesses are fixed.
+    }
+    {
+        // The booth is known now, so planning it is no longer needed.
+        unique_lock<mutex> guard(this->lock);
+        vector<Job*> superseded;
+        for (deque<Job*>::iterator it = this->queue.begin(); it != this->queue.end(); ++it) {
+            if ((*it)->isWholeWeek) {
+                superseded.push_back(*it);
+            }
+        }
+        for (vector<Job*>::iterator it = superseded.begin(); it != superseded.end(); ++it) {
+            this->removeJob(*it);
+        }
+    }
+    this->addPerfectMatchingJobs(possibleAnswers, tbGuess, pmGuessesAlreadyMade);
+}
+
+void GuessSpeculator::speculatePerfectMatching(const PmSet* possibleAnswers,
+                                               const Pm& pmGuess,
+                                               const TbSet* tbGuessesAlreadyMade,
+                                               const PmSet* pmGuessesAlreadyMade) {
+    if (pmGuessesAlreadyMade->size() < 2) {
+        return; // Next week's guess is still fixed.
+    }
+
+    // One state per number correct, short of winning.
+    vector<PmSet*> states;
+    for (int numCorrect = 0; numCorrect < PERM_LENGTH; ++numCorrect) {
+        PmSet* state = new PmSet(possibleAnswers->begin(), possibleAnswers->end());
+        state->filter(pmGuess, numCorrect);
+        if (state->size() == 0) {
+            delete state;
+            continue;
+        }
+        states.push_back(state);
+    }
+    sort(states.begin(), states.end(), isLarger);
+
+    unique_lock<mutex> guard(this->lock);
+    for (vector<PmSet*>::iterator it = states.begin(); it != states.end(); ++it) {
+        Job* job = new Job();
+        job->possibleAnswers = *it;
+        job->pmGuessesAlreadyMade = new PmSet(pmGuessesAlreadyMade->begin(),
+                                              pmGuessesAlreadyMade->end());
+        for (unsigned int i = 0; i < tbGuessesAlreadyMade->size(); ++i) {
+            job->tbGuessesAlreadyMade.push_back(tbGuessesAlreadyMade->get(int(i)));
+        }
+        job->isWholeWeek = true;
+        job->key = ~getKey(*it, pmGuessesAlreadyMade); // Never taken as a guess.
+        this->jobs.push_back(job);
+        this->queue.push_back(job);
+    }
+    this->changed.notify_all();
+}
+
+void GuessSpeculator::discardUnreachable(const PmSet* possibleAnswers) {
+    vector<PmRank> remaining;
+    remaining.reserve(possibleAnswers->size());
+    for (PmSet::const_iterator it = possibleAnswers->begin(); it != possibleAnswers->end(); ++it) {
+        remaining.push_back(it.rank());
+    }
+    sort(remaining.begin(), remaining.end());
+
+    unique_lock<mutex> guard(this->lock);
+    vector<Job*> unreachable;
+    for (vector<Job*>::iterator it = this->jobs.begin(); it != this->jobs.end(); ++it) {
+        if (!binary_search(remaining.begin(),
+                           remaining.end(),
+                           (*it)->possibleAnswers->begin().rank())) {
+            unreachable.push_back(*it);
+        }
+    }
+    for (vector<Job*>::iterator it = unreachable.begin(); it != unreachable.end(); ++it) {
+        if (*it == this->running) {
+            (*it)->isCancelled = true; // Removed by the background thread.
+        } else {
+            this->removeJob(*it);
+        }
+    }
+}
+
+bool GuessSpeculator::isReady(const PmSet* possibleAnswers, const PmSet* pmGuessesAlreadyMade) {
+    unique_lock<mutex> guard(this->lock);
+    Job* job = this->findJob(possibleAnswers, pmGuessesAlreadyMade);
+    return job && job->isDone;
+}
+
+bool GuessSpeculator::takeGuess(const PmSet* possibleAnswers,
+                                const PmSet* pmGuessesAlreadyMade,
+                                Pm* guess) {
+    unique_lock<mutex> guard(this->lock);
+    Job* job = this->findJob(possibleAnswers, pmGuessesAlreadyMade);
+    if (!job) {
+        return false;
+    }
+
+    // A queued job jumps ahead of the ones that can no longer be needed first.
+    deque<Job*>::iterator queued = std::find(this->queue.begin(), this->queue.end(), job);
+    if (queued != this->queue.end()) {
+        this->queue.erase(queued);
+        this->queue.push_front(job);
+        this->changed.notify_all();
+    }
+    while (!job->isDone) {
+        this->changed.wait(guard);
+    }
+    *guess = job->guess;
+    this->removeJob(job);
+    return true;
+}
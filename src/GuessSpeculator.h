@@ -0,0 +1,133 @@
+/**
+ * GuessSpeculator.h
+ * Christopher Chute
+ *
+ * Compute guesses in the background while interactive mode waits for the
+ * player's feedback. Every feedback the player might give leads to its own
+ * set of remaining answers; the guesses for the likeliest ones are worked
+ * out ahead of time, and the rest are cancelled once the feedback is in.
+ * Moves a decision tree or lookahead makes are not speculated.
+ */
+
+#ifndef GUARD_GUESS_SPECULATOR_H
+#define GUARD_GUESS_SPECULATOR_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "ayto.h"
+
+class GuessSpeculator {
+private:
+    // A state to find the Perfect Matching guess for. A whole-week job only
+    // knows the state after a Perfect Matching, so it first picks the Truth
+    // Booth, then queues a job for each of the booth's answers.
+    struct Job {
+        PmSet* possibleAnswers;          // Remaining answers in this state.
+        PmSet* pmGuessesAlreadyMade;     // Perfect Matchings submitted so far.
+        std::vector<Tb> tbGuessesAlreadyMade; // Booths so far, for whole weeks.
+        bool isWholeWeek;                // Truth Booth still to be chosen.
+        uint64_t key;                    // Identifies the state, see getKey.
+        Pm guess;                        // Result, once isDone.
+        bool isDone;
+        std::atomic<bool> isCancelled;   // Checked by the minimax threads.
+        Job() : possibleAnswers(nullptr), pmGuessesAlreadyMade(nullptr),
+                isWholeWeek(false), key(0), isDone(false), isCancelled(false) {}
+        ~Job() { delete possibleAnswers; delete pmGuessesAlreadyMade; }
+    };
+
+    const MinimaxCostModel* costModel; // Stage choice, as for the real guess.
+    ScoringPolicies scoringPolicies;   // Scoring, as for the real guess.
+    const DecisionTree* decisionTree;  // Moves played from a tree, or nullptr.
+    bool isLookahead;                  // Lookahead picks whole weeks off the tree.
+    std::vector<Job*> jobs;            // Queued, running and finished jobs.
+    std::deque<Job*> queue;            // Jobs not started yet, likeliest first.
+    Job* running;                      // Job the background thread is on.
+    bool isStopping;
+    std::mutex lock;                   // Guards everything above.
+    std::condition_variable changed;   // Signals new jobs and finished jobs.
+    std::thread worker;
+
+    static uint64_t getKey(const PmSet* possibleAnswers, const PmSet* pmGuessesAlreadyMade);
+    Job* findJob(const PmSet* possibleAnswers, const PmSet* pmGuessesAlreadyMade) const;
+    void removeJob(Job* job);
+    void addPerfectMatchingJobs(const PmSet* possibleAnswers,
+                                const Tb& tbGuess,
+                                const PmSet* pmGuessesAlreadyMade);
+    void run();
+public:
+    /**
+     * Start the background thread, idle until given something to do.
+     * @param costModel Chooses the minimax stage, or nullptr for fixed thresholds.
+     * @param scoringPolicies How each minimax stage scores candidates.
+     * @param decisionTree Tree the game plays from where it can, or nullptr.
+     * @param isLookahead Whether lookahead picks the weeks the tree does not.
+     */
+    explicit GuessSpeculator(const MinimaxCostModel* costModel,
+                             const ScoringPolicies& scoringPolicies = ScoringPolicies(),
+                             const DecisionTree* decisionTree = nullptr,
+                             bool isLookahead = false);
+
+    /**
+     * Cancel all work and stop the background thread.
+     */
+    ~GuessSpeculator();
+
+    /**
+     * While waiting for a Truth Booth answer, find next Perfect Matching
+     * guess for both answers, the one leaving more answers first.
+     * @param possibleAnswers Remaining answers before the booth.
+     * @param tbGuess Booth the player is asked about.
+     * @param pmGuessesAlreadyMade Perfect Matchings submitted so far.
+     */
+    void speculateTruthBooth(const PmSet* possibleAnswers,
+                             const Tb& tbGuess,
+                             const PmSet* pmGuessesAlreadyMade);
+
+    /**
+     * While waiting for a Perfect Matching answer, plan next week for each
+     * possible number correct, the ones leaving more answers first: pick the
+     * Truth Booth, then the Perfect Matching guess for both booth answers.
+     * @param possibleAnswers Remaining answers before the Perfect Matching.
+     * @param pmGuess Perfect Matching the player is asked about.
+     * @param tbGuessesAlreadyMade Truth Booths submitted so far.
+     * @param pmGuessesAlreadyMade Perfect Matchings so far, including pmGuess.
+     */
+    void speculatePerfectMatching(const PmSet* possibleAnswers,
+                                  const Pm& pmGuess,
+                                  const TbSet* tbGuessesAlreadyMade,
+                                  const PmSet* pmGuessesAlreadyMade);
+
+    /**
+     * Cancel the jobs ruled out by feedback. Different feedback leaves
+     * disjoint sets of answers, so a job is still reachable exactly when
+     * one of its answers remains.
+     * @param possibleAnswers Remaining answers after the feedback.
+     */
+    void discardUnreachable(const PmSet* possibleAnswers);
+
+    /**
+     * Check whether the guess for a state has already been found.
+     * @param possibleAnswers Remaining answers.
+     * @param pmGuessesAlreadyMade Perfect Matchings submitted so far.
+     * @return True if takeGuess would return without waiting.
+     */
+    bool isReady(const PmSet* possibleAnswers, const PmSet* pmGuessesAlreadyMade);
+
+    /**
+     * Get the speculated guess for a state, waiting for it if it is queued
+     * or being worked on.
+     * @param possibleAnswers Remaining answers.
+     * @param pmGuessesAlreadyMade Perfect Matchings submitted so far.
+     * @param guess Where the guess goes.
+     * @return True if the guess was speculated, false if the caller should
+     * find it itself.
+     */
+    bool takeGuess(const PmSet* possibleAnswers, const PmSet* pmGuessesAlreadyMade, Pm* guess);
+};
+
+#endif
@@ -0,0 +1,93 @@
+/**
+ * MinimaxCostModel.cpp
+ * Christopher Chute
+ *
+ * Predict how long each stage of minimax takes on this machine.
+ */
+
+#include <chrono>
+#include "AnswerTrie.h"
+#include "MinimaxCostModel.h"
+#include "PerfectMatching.h"
+#include "PerfectMatchingSet.h"
+#include "PerfectMatchingUniverse.h"
+#include "TruthBooth.h"
+
+#define CALIBRATION_CANDIDATES (100) // Candidates scored while calibrating.
+
+typedef PerfectMatching Pm;
+
+// Only keeps the calibration loop from being optimized away.
+static volatile long calibrationChecksum;
+
+MinimaxCostModel::MinimaxCostModel(double b, int n) :
+        budgetSeconds(b),
+        secondsPerComparison(0),
+        secondsPerTrieAnswer(0),
+        numParallel(n > 0 ? n : 1)
+{}
+
+void MinimaxCostModel::calibrate() {
+    // Same loop as getBestGuessFromSubset, on the answers a game has left
+    // after the first week's booth and DIGITS, rather than on answers spread
+    // evenly over the universe, which share fewer prefixes in the trie.
+    const PerfectMatchingUniverse& universe = PerfectMatchingUniverse::get();
+    const Pm& answer = universe.at(NUM_PERMS / 2);
+    PerfectMatchingSet survivors;
+    survivors.populateAll();
+    TruthBooth firstBooth(0, '0');
+    survivors.filter(firstBooth, firstBooth.isContainedIn(answer));
+    survivors.filter(DIGITS, numInCommon(DIGITS, answer));
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    const AnswerTrie answers(&survivors);
+    std::chrono::steady_clock::time_point built = std::chrono::steady_clock::now();
+    long checksum = 0;
+    for (int c = 0; c < CALIBRATION_CANDIDATES; ++c) {
+        const Pm& guess = universe.at(PerfectMatchingRank(long(c) * 36277 % NUM_PERMS));
+        int numRemainingGivenResponse[PERM_LENGTH + 1];
+        answers.countResponses(guess, numRemainingGivenResponse);
+        checksum += numRemainingGivenResponse[c % (PERM_LENGTH + 1)];
+    }
+    std::chrono::duration<double> building = built - start;
+    std::chrono::duration<double> scoring = std::chrono::steady_clock::now() - built;
+
+    calibrationChecksum = checksum;
+    double numAnswers = double(survivors.size());
+    this->secondsPerTrieAnswer = building.count() / numAnswers;
+    this->secondsPerComparison = scoring.count() / (double(CALIBRATION_CANDIDATES) * numAnswers);
+}
+
+double MinimaxCostModel::predictSeconds(size_t numCandidates, size_t numAnswers) const {
+    return double(numAnswers) * this->secondsPerTrieAnswer +
+           double(numCandidates) * double(numAnswers) * this->secondsPerComparison /
+           this->numParallel;
+}
+
+size_t MinimaxCostModel::getNumCandidates(MinimaxStage stage, size_t numAnswers, size_t poolSize) {
+    switch (stage) {
+        case POOL_MINIMAX:
+            return poolSize;
+        case PARTIAL_MINIMAX:
+            return numAnswers;
+        case POOL_AND_PARTIAL_MINIMAX:
+            return poolSize + numAnswers;
+        default:
+            return NUM_PERMS;
+    }
+}
+
+MinimaxStage MinimaxCostModel::chooseStage(size_t numAnswers, size_t poolSize) const {
+    MinimaxStage larger = numAnswers > poolSize ? PARTIAL_MINIMAX : POOL_MINIMAX;
+    MinimaxStage smaller = numAnswers > poolSize ? POOL_MINIMAX : PARTIAL_MINIMAX;
+    MinimaxStage byThoroughness[NUM_MINIMAX_STAGES] = {
+            FULL_MINIMAX, POOL_AND_PARTIAL_MINIMAX, larger, smaller };
+
+    for (int i = 0; i < NUM_MINIMAX_STAGES; ++i) {
+        size_t numCandidates = getNumCandidates(byThoroughness[i], numAnswers, poolSize);
+        if (this->predictSeconds(numCandidates, numAnswers) <= this->budgetSeconds) {
+            return byThoroughness[i];
+        }
+    }
+    return smaller;
+}
@@ -0,0 +1,83 @@
+/**
+ * MinimaxCostModel.h
+ * Christopher Chute
+ *
+ * Predict how long each stage of minimax takes on this machine, and choose
+ * the most thorough stage that fits in a time budget for the week.
+ */
+
+#ifndef GUARD_MINIMAX_COST_MODEL_H
+#define GUARD_MINIMAX_COST_MODEL_H
+
+#include <cstddef>
+
+/**
+ * Stages of minimax, from cheapest to most thorough. They differ in which
+ * candidate guesses are scored against the remaining answers.
+ */
+enum MinimaxStage {
+    POOL_MINIMAX,             // Candidates are the fixed pool.
+    PARTIAL_MINIMAX,          // Candidates are the remaining answers.
+    POOL_AND_PARTIAL_MINIMAX, // Candidates are the pool and the remaining answers.
+    FULL_MINIMAX              // Candidates are all permutations.
+};
+#define NUM_MINIMAX_STAGES (4)
+
+class MinimaxCostModel {
+private:
+    double budgetSeconds;        // Time allowed for one Perfect Matching guess.
+    double secondsPerComparison; // Time to score one candidate against one answer.
+    double secondsPerTrieAnswer; // Time to add one answer to the trie scored against.
+    int numParallel;             // Threads or workers scoring at the same time.
+public:
+    /**
+     * Create a cost model. Call calibrate before choosing stages.
+     * @param budgetSeconds Time allowed for one Perfect Matching guess.
+     * @param numParallel Threads or workers scoring candidates at once.
+     */
+    MinimaxCostModel(double budgetSeconds, int numParallel);
+
+    /**
+     * Time the inner loop of minimax on this machine, single-threaded, on
+     * the answers left after a simulated first week. Building the trie of
+     * those answers is timed apart from scoring against it.
+     */
+    void calibrate();
+
+    /**
+     * Predict the time to build the trie of the answers once, then score
+     * candidates against it in parallel.
+     * @param numCandidates Number of candidate guesses.
+     * @param numAnswers Number of remaining answers.
+     * @return Predicted wall-clock seconds.
+     */
+    double predictSeconds(size_t numCandidates, size_t numAnswers) const;
+
+    /**
+     * Get the number of candidates a stage scores.
+     * @param stage Stage of minimax.
+     * @param numAnswers Number of remaining answers.
+     * @param poolSize Number of guesses in the fixed pool.
+     * @return Number of candidates, counting pool guesses that are also
+     * remaining answers twice.
+     */
+    static size_t getNumCandidates(MinimaxStage stage, size_t numAnswers, size_t poolSize);
+
+    /**
+     * Choose the most thorough stage predicted to fit in the budget. Full
+     * and combined minimax score supersets of the other stages' candidates;
+     * between the pool and the remaining answers, the larger set is tried
+     * first. If no stage fits, the cheapest is chosen.
+     * @param numAnswers Number of remaining answers.
+     * @param poolSize Number of guesses in the fixed pool.
+     * @return Stage to use for the next Perfect Matching guess.
+     */
+    MinimaxStage chooseStage(size_t numAnswers, size_t poolSize) const;
+
+    double getBudgetSeconds() const { return this->budgetSeconds; }
+    double getSecondsPerComparison() const { return this->secondsPerComparison; }
+    double getSecondsPerTrieAnswer() const { return this->secondsPerTrieAnswer; }
+    int getNumParallel() const { return this->numParallel; }
+};
+
+#endif
@@ -0,0 +1,132 @@
+/**
+ * MinimaxHistograms.cpp
+ * Christopher Chute
+ *
+ * Per-candidate histograms of feedback over the remaining answers, kept
+ * from one week to the next.
+ */
+
+#include <functional>
+#include <thread>
+#include "AnswerTrie.h"
+#include "MinimaxHistograms.h"
+#include "PerfectMatchingUniverse.h"
+
+using std::thread;
+using std::vector;
+
+typedef PerfectMatching Pm;
+typedef PerfectMatchingRank PmRank;
+typedef PerfectMatchingSet PmSet;
+
+// Add sign to each candidate's bucket for every answer, over a range of candidates.
+static void countAnswers(const vector<PmRank>* candidates,
+                         size_t firstCandidate,
+                         size_t endCandidate,
+                         const AnswerTrie& answers,
+                         int sign,
+                         vector<int>* histograms) {
+    const PerfectMatchingUniverse& universe = PerfectMatchingUniverse::get();
+
+    for (size_t i = firstCandidate; i < endCandidate; ++i) {
+        int numGivenResponse[NUM_RESPONSES];
+        answers.countResponses(universe.at((*candidates)[i]), numGivenResponse);
+        int* histogram = &(*histograms)[i * NUM_RESPONSES];
+        for (int r = 0; r < NUM_RESPONSES; ++r) {
+            histogram[r] += sign * numGivenResponse[r];
+        }
+    }
+}
+
+MinimaxHistograms::MinimaxHistograms(int n) :
+        candidates(new vector<PmRank>()),
+        answers(new vector<PmRank>()),
+        histograms(new vector<int>()),
+        numThreads(n)
+{}
+
+MinimaxHistograms::~MinimaxHistograms() {
+    delete this->candidates;
+    delete this->answers;
+    delete this->histograms;
+}
+
+bool MinimaxHistograms::keepCandidates(const PmSet* newCandidates) {
+    // Walk both lists in order, keeping the rows of candidates that remain.
+    vector<PmRank> keptCandidates;
+    vector<int> keptHistograms;
+    keptCandidates.reserve(newCandidates->size());
+    keptHistograms.reserve(newCandidates->size() * NUM_RESPONSES);
+
+    size_t i = 0;
+    for (PmSet::const_iterator it = newCandidates->begin(); it != newCandidates->end(); ++it) {
+        while (i < this->candidates->size() && (*this->candidates)[i] != it.rank()) {
+            ++i;
+        }
+        if (i == this->candidates->size()) {
+            return false;
+        }
+        keptCandidates.push_back(it.rank());
+        keptHistograms.insert(keptHistograms.end(),
+                              this->histograms->begin() + i * NUM_RESPONSES,
+                              this->histograms->begin() + (i + 1) * NUM_RESPONSES);
+        ++i;
+    }
+
+    this->candidates->swap(keptCandidates);
+    this->histograms->swap(keptHistograms);
+    return true;
+}
+
+void MinimaxHistograms::recount(const vector<PmRank>& answersToCount, int sign) {
+    // One trie of the answers, read by every counting thread.
+    const AnswerTrie answers(answersToCount);
+    vector<thread> countingThreads;
+    size_t numCandidates = this->candidates->size();
+    for (int id = 0; id < this->numThreads; ++id) {
+        countingThreads.push_back(thread(countAnswers,
+                                         this->candidates,
+                                         numCandidates * id / this->numThreads,
+                                         numCandidates * (id + 1) / this->numThreads,
+                                         std::cref(answers),
+                                         sign,
+                                         this->histograms));
+    }
+    for (vector<thread>::iterator it = countingThreads.begin(); it != countingThreads.end(); ++it) {
+        it->join();
+    }
+}
+
+void MinimaxHistograms::update(const PmSet* newCandidates, const PmSet* possibleAnswers) {
+    // Answers removed since the last update, if survivors are a subsequence.
+    vector<PmRank> removedAnswers;
+    PmSet::const_iterator survivor = possibleAnswers->begin();
+    for (vector<PmRank>::const_iterator it = this->answers->begin();
+         it != this->answers->end();
+         ++it) {
+        if (survivor != possibleAnswers->end() && survivor.rank() == *it) {
+            ++survivor;
+        } else {
+            removedAnswers.push_back(*it);
+        }
+    }
+    bool isFiltered = !this->answers->empty() && survivor == possibleAnswers->end();
+
+    this->answers->clear();
+    for (PmSet::const_iterator it = possibleAnswers->begin(); it != possibleAnswers->end(); ++it) {
+        this->answers->push_back(it.rank());
+    }
+
+    if (isFiltered && removedAnswers.size() < this->answers->size() &&
+            this->keepCandidates(newCandidates)) {
+        this->recount(removedAnswers, -1);
+        return;
+    }
+
+    this->candidates->clear();
+    for (PmSet::const_iterator it = newCandidates->begin(); it != newCandidates->end(); ++it) {
+        this->candidates->push_back(it.rank());
+    }
+    this->histograms->assign(this->candidates->size() * NUM_RESPONSES, 0);
+    this->recount(*this->answers, 1);
+}
@@ -0,0 +1,68 @@
+/**
+ * MinimaxHistograms.h
+ * Christopher Chute
+ *
+ * Per-candidate histograms of feedback over the remaining answers, kept
+ * from one week to the next. The remaining answers only ever shrink, so a
+ * week's histograms can be found by subtracting the answers that were just
+ * ruled out, instead of counting the survivors all over again.
+ */
+
+#ifndef GUARD_MINIMAX_HISTOGRAMS_H
+#define GUARD_MINIMAX_HISTOGRAMS_H
+
+#include <vector>
+#include "PerfectMatching.h"
+#include "PerfectMatchingSet.h"
+
+#define NUM_RESPONSES (PERM_LENGTH + 1) // Possible feedback: 0 to 10 correct.
+
+class MinimaxHistograms {
+private:
+    std::vector<PerfectMatchingRank>* candidates; // Guesses with a histogram.
+    std::vector<PerfectMatchingRank>* answers;    // Answers counted in them.
+    std::vector<int>* histograms;                 // NUM_RESPONSES per candidate.
+    int numThreads;                               // Threads used to count.
+
+    bool keepCandidates(const PerfectMatchingSet* newCandidates);
+    void recount(const std::vector<PerfectMatchingRank>& answersToCount, int sign);
+public:
+    /**
+     * Create an empty set of histograms.
+     * @param numThreads Number of threads to count answers with.
+     */
+    explicit MinimaxHistograms(int numThreads);
+    ~MinimaxHistograms();
+
+    /**
+     * Bring the histograms up to date for a set of candidates and answers.
+     * When the candidates are a subset of last time's and the answers were
+     * only filtered since, the removed answers are subtracted if there are
+     * fewer of them than survivors; otherwise the survivors are recounted.
+     * @param candidates Guesses to keep histograms for.
+     * @param possibleAnswers Remaining possibilities for the answer.
+     */
+    void update(const PerfectMatchingSet* candidates, const PerfectMatchingSet* possibleAnswers);
+
+    /**
+     * Get the number of candidates with a histogram.
+     * @return Number of candidates passed to the last update.
+     */
+    size_t getNumCandidates() const { return this->candidates->size(); }
+
+    /**
+     * Get the rank of a candidate.
+     * @param i Index of the candidate, in the order passed to update.
+     * @return Rank of the i-th candidate.
+     */
+    PerfectMatchingRank getCandidate(size_t i) const { return (*this->candidates)[i]; }
+
+    /**
+     * Get the histogram of a candidate.
+     * @param i Index of the candidate, in the order passed to update.
+     * @return NUM_RESPONSES counts, indexed by number correct.
+     */
+    const int* getHistogram(size_t i) const { return &(*this->histograms)[i * NUM_RESPONSES]; }
+};
+
+#endif
@@ -0,0 +1,379 @@
+/**
+ * MinimaxWorkers.cpp
+ * Christopher Chute
+ *
+ * Spread the candidates of one minimax decision across worker processes.
+ */
+
+#include <algorithm>
+#include <cerrno>
+#include <csignal>
+#include <cstdint>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "MinimaxWorkers.h"
+#include "PerfectMatchingUniverse.h"
+#include "ayto.h"
+
+#define MSG_SNAPSHOT (1) // Scoring policy, remaining answers and guesses already made.
+#define MSG_UNIT     (2) // A chunk of candidate guesses to evaluate.
+#define MSG_RESULT   (3) // Best guess in a chunk and its score, low word first.
+#define MSG_SHUTDOWN (4) // No more work, worker should exit.
+
+using std::chrono::duration_cast;
+using std::chrono::milliseconds;
+using std::chrono::steady_clock;
+using std::pair;
+using std::vector;
+
+typedef PerfectMatching Pm;
+typedef PerfectMatchingRank PmRank;
+typedef PerfectMatchingSet PmSet;
+
+// Every message is a header followed by length 32-bit words of payload.
+struct MessageHeader {
+    uint32_t type;
+    uint32_t length;
+};
+
+static bool writeAll(int fd, const void* buffer, size_t numBytes) {
+    const char* next = static_cast<const char*>(buffer);
+    while (numBytes > 0) {
+        ssize_t numWritten = write(fd, next, numBytes);
+        if (numWritten < 0 && errno == EINTR) {
+            continue;
+        }
+        if (numWritten <= 0) {
+            return false;
+        }
+        next += numWritten;
+        numBytes -= size_t(numWritten);
+    }
+    return true;
+}
+
+static bool readAll(int fd, void* buffer, size_t numBytes) {
+    char* next = static_cast<char*>(buffer);
+    while (numBytes > 0) {
+        ssize_t numRead = read(fd, next, numBytes);
+        if (numRead < 0 && errno == EINTR) {
+            continue;
+        }
+        if (numRead <= 0) {
+            return false;
+        }
+        next += numRead;
+        numBytes -= size_t(numRead);
+    }
+    return true;
+}
+
+static bool sendMessage(int fd, uint32_t type, const vector<uint32_t>& payload) {
+    MessageHeader header = { type, uint32_t(payload.size()) };
+    return writeAll(fd, &header, sizeof(header)) &&
+           writeAll(fd, payload.data(), payload.size() * sizeof(uint32_t));
+}
+
+static bool receiveMessage(int fd, uint32_t& type, vector<uint32_t>& payload) {
+    MessageHeader header;
+    if (!readAll(fd, &header, sizeof(header))) {
+        return false;
+    }
+    type = header.type;
+    payload.resize(header.length);
+    return readAll(fd, payload.data(), payload.size() * sizeof(uint32_t));
+}
+
+// Append a set to a payload as its size followed by its ranks.
+static void appendSet(vector<uint32_t>& payload, const PmSet* set) {
+    payload.push_back(uint32_t(set->size()));
+    for (PmSet::const_iterator it = set->begin(); it != set->end(); ++it) {
+        payload.push_back(it.rank());
+    }
+}
+
+// Read a set written by appendSet, starting at offset, and advance offset.
+static bool extractSet(const vector<uint32_t>& payload, size_t& offset, PmSet* set) {
+    if (offset >= payload.size() || payload.size() - offset - 1 < payload[offset]) {
+        return false;
+    }
+    size_t count = payload[offset++];
+    for (size_t i = 0; i < count; ++i) {
+        if (payload[offset] >= NUM_PERMS) {
+            return false;
+        }
+        set->addRank(payload[offset++]);
+    }
+    return true;
+}
+
+// Evaluate one chunk in this process, the same way a minimax thread does.
+static pair<Pm, long> evaluateChunk(const PmSet* possibleAnswers,
+                                    const AnswerTrie* answerTrie,
+                                    const PmSet* chunk,
+                                    const GuessHistory* guessesAlreadyMade,
+                                    ScoringPolicy scoringPolicy) {
+    vector<pair<Pm, long> > bestGuess(1);
+    ArgsForMinimaxThread args(0, possibleAnswers, answerTrie, chunk, guessesAlreadyMade,
+                              &bestGuess, nullptr, scoringPolicy);
+    getBestGuessFromSubset(&args);
+    return bestGuess[0];
+}
+
+MinimaxCoordinator::MinimaxCoordinator(int numWorkers, int unitTimeoutSeconds) :
+        workers(new vector<Worker>()),
+        decisionId(0),
+        unitTimeout(unitTimeoutSeconds)
+{
+    // A lost worker must show up as a failed write, not kill the coordinator.
+    signal(SIGPIPE, SIG_IGN);
+
+    for (int i = 0; i < numWorkers; ++i) {
+        int fds[2];
+        if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, fds) != 0) {
+            break;
+        }
+
+        pid_t pid = fork();
+        if (pid == 0) {
+            // Worker: the socket becomes stdin and stdout of a fresh image.
+            dup2(fds[1], STDIN_FILENO);
+            dup2(fds[1], STDOUT_FILENO);
+            execl("/proc/self/exe", "ayto", "--worker", (char*) nullptr);
+
+            // No exec available, serve from this copy of the process instead.
+            for (vector<Worker>::iterator it = this->workers->begin();
+                 it != this->workers->end();
+                 ++it) {
+                close(it->fd);
+            }
+            close(fds[0]);
+            runMinimaxWorker(STDIN_FILENO, STDOUT_FILENO);
+            _exit(EXIT_SUCCESS);
+        }
+
+        close(fds[1]);
+        if (pid < 0) {
+            close(fds[0]);
+            break;
+        }
+        Worker worker = { pid, fds[0], -1, steady_clock::time_point() };
+        this->workers->push_back(worker);
+    }
+}
+
+MinimaxCoordinator::~MinimaxCoordinator() {
+    for (vector<Worker>::iterator it = this->workers->begin();
+         it != this->workers->end();
+         ++it) {
+        if (it->fd >= 0) {
+            sendMessage(it->fd, MSG_SHUTDOWN, vector<uint32_t>());
+            close(it->fd);
+        }
+        waitpid(it->pid, nullptr, 0);
+    }
+    delete this->workers;
+}
+
+int MinimaxCoordinator::getNumWorkers() const {
+    int numWorkers = 0;
+    for (vector<Worker>::const_iterator it = this->workers->begin();
+         it != this->workers->end();
+         ++it) {
+        if (it->fd >= 0) {
+            ++numWorkers;
+        }
+    }
+    return numWorkers;
+}
+
+int MinimaxCoordinator::getNumUnits() const {
+    return this->getNumWorkers() * UNITS_PER_WORKER;
+}
+
+void MinimaxCoordinator::markLost(Worker& worker, vector<int>& unitsToAssign) {
+    if (worker.unitInFlight >= 0) {
+        unitsToAssign.push_back(worker.unitInFlight);
+        worker.unitInFlight = -1;
+    }
+    close(worker.fd);
+    worker.fd = -1;
+    kill(worker.pid, SIGKILL);
+}
+
+void MinimaxCoordinator::evaluateChunks(const PmSet* possibleAnswers,
+                                        const PmSet* guessesAlreadyMade,
+                                        PmSet** chunks,
+                                        int numChunks,
+                                        ScoringPolicy scoringPolicy,
+                                        vector<pair<Pm, long> >* bestGuesses,
+                                        vector<int>* unitsLeft) {
+    ++this->decisionId;
+
+    vector<uint32_t> snapshot(1, this->decisionId);
+    snapshot.push_back(uint32_t(scoringPolicy));
+    appendSet(snapshot, possibleAnswers);
+    appendSet(snapshot, guessesAlreadyMade);
+    vector<int> unitsToAssign;
+    for (vector<Worker>::iterator it = this->workers->begin();
+         it != this->workers->end();
+         ++it) {
+        if (it->fd >= 0 && !sendMessage(it->fd, MSG_SNAPSHOT, snapshot)) {
+            this->markLost(*it, unitsToAssign);
+        }
+    }
+
+    // Hand out units in reverse so they are assigned in order.
+    for (int unit = numChunks - 1; unit >= 0; --unit) {
+        unitsToAssign.push_back(unit);
+    }
+    int numUnitsDone = 0;
+    vector<uint32_t> payload;
+    vector<struct pollfd> pollFds;
+    vector<Worker*> polledWorkers;
+
+    while (numUnitsDone < numChunks) {
+        // Give every idle worker a unit.
+        for (vector<Worker>::iterator it = this->workers->begin();
+             it != this->workers->end() && !unitsToAssign.empty();
+             ++it) {
+            if (it->fd < 0 || it->unitInFlight >= 0) {
+                continue;
+            }
+            int unit = unitsToAssign.back();
+            unitsToAssign.pop_back();
+            payload.assign(1, this->decisionId);
+            payload.push_back(uint32_t(unit));
+            appendSet(payload, chunks[unit]);
+            it->unitInFlight = unit;
+            it->deadline = steady_clock::now() + this->unitTimeout;
+            if (!sendMessage(it->fd, MSG_UNIT, payload)) {
+                this->markLost(*it, unitsToAssign);
+            }
+        }
+
+        // Wait for results from busy workers, until the first deadline.
+        pollFds.clear();
+        polledWorkers.clear();
+        steady_clock::time_point firstDeadline = steady_clock::time_point::max();
+        for (vector<Worker>::iterator it = this->workers->begin();
+             it != this->workers->end();
+             ++it) {
+            if (it->fd >= 0 && it->unitInFlight >= 0) {
+                struct pollfd pollFd = { it->fd, POLLIN, 0 };
+                pollFds.push_back(pollFd);
+                polledWorkers.push_back(&*it);
+                firstDeadline = std::min(firstDeadline, it->deadline);
+            }
+        }
+        if (pollFds.empty()) {
+            break; // Every worker is lost.
+        }
+        milliseconds timeout = duration_cast<milliseconds>(firstDeadline - steady_clock::now());
+        int numReady = poll(pollFds.data(), pollFds.size(),
+                            int(std::max(timeout.count() + 1, milliseconds::rep(0))));
+        if (numReady < 0 && errno != EINTR) {
+            break;
+        }
+
+        steady_clock::time_point now = steady_clock::now();
+        for (size_t i = 0; i < pollFds.size(); ++i) {
+            Worker& worker = *polledWorkers[i];
+            if (!pollFds[i].revents) {
+                if (numReady >= 0 && now >= worker.deadline) {
+                    this->markLost(worker, unitsToAssign); // Hung, or far too slow.
+                }
+                continue;
+            }
+            uint32_t type;
+            if (!receiveMessage(worker.fd, type, payload) ||
+                    type != MSG_RESULT ||
+                    payload.size() != 5 ||
+                    payload[0] != this->decisionId ||
+                    int(payload[1]) != worker.unitInFlight ||
+                    payload[2] >= NUM_PERMS) {
+                this->markLost(worker, unitsToAssign);
+                continue;
+            }
+            Pm guess = PerfectMatchingUniverse::get().at(payload[2]);
+            uint64_t score = uint64_t(payload[3]) | (uint64_t(payload[4]) << 32);
+            (*bestGuesses)[worker.unitInFlight] = pair<Pm, long>(guess, long(int64_t(score)));
+            worker.unitInFlight = -1;
+            ++numUnitsDone;
+        }
+    }
+
+    // Whatever could not be handed out goes back to the caller.
+    for (vector<Worker>::iterator it = this->workers->begin();
+         it != this->workers->end();
+         ++it) {
+        if (it->unitInFlight >= 0) {
+            this->markLost(*it, unitsToAssign);
+        }
+    }
+    unitsLeft->assign(unitsToAssign.begin(), unitsToAssign.end());
+    std::sort(unitsLeft->begin(), unitsLeft->end());
+}
+
+void runMinimaxWorker(int inputFd, int outputFd) {
+    PmSet* possibleAnswers = new PmSet();
+    PmSet* guessesAlreadyMade = new PmSet();
+    AnswerTrie* answerTrie = nullptr;   // Built once per snapshot, for every unit.
+    GuessHistory* history = nullptr;
+    ScoringPolicy scoringPolicy = MINIMAX_SCORE;
+    uint32_t decisionId = 0;
+    uint32_t type;
+    vector<uint32_t> payload;
+
+    while (receiveMessage(inputFd, type, payload)) {
+        if (type == MSG_SNAPSHOT) {
+            delete possibleAnswers;
+            delete guessesAlreadyMade;
+            possibleAnswers = new PmSet();
+            guessesAlreadyMade = new PmSet();
+            size_t offset = 2;
+            if (payload.size() < 2 ||
+                    payload[1] > uint32_t(MOST_PARTS_SCORE) ||
+                    !extractSet(payload, offset, possibleAnswers) ||
+                    !extractSet(payload, offset, guessesAlreadyMade)) {
+                break;
+            }
+            decisionId = payload[0];
+            scoringPolicy = ScoringPolicy(payload[1]);
+            delete answerTrie;
+            delete history;
+            answerTrie = new AnswerTrie(possibleAnswers);
+            history = new GuessHistory(guessesAlreadyMade);
+        } else if (type == MSG_UNIT) {
+            PmSet chunk;
+            size_t offset = 2;
+            if (payload.size() < 2 || payload[0] != decisionId || !answerTrie ||
+                    !extractSet(payload, offset, &chunk)) {
+                break;
+            }
+            pair<Pm, long> best = evaluateChunk(possibleAnswers,
+                                                answerTrie,
+                                                &chunk,
+                                                history,
+                                                scoringPolicy);
+            vector<uint32_t> result;
+            result.push_back(decisionId);
+            result.push_back(payload[1]);
+            result.push_back(getRank(best.first));
+            result.push_back(uint32_t(uint64_t(best.second)));
+            result.push_back(uint32_t(uint64_t(best.second) >> 32));
+            if (!sendMessage(outputFd, MSG_RESULT, result)) {
+                break;
+            }
+        } else {
+            break;
+        }
+    }
+
+    delete answerTrie;
+    delete history;
+    delete possibleAnswers;
+    delete guessesAlreadyMade;
+}
@@ -0,0 +1,91 @@
+/**
+ * MinimaxWorkers.h
+ * Christopher Chute
+ *
+ * Spread the candidates of one minimax decision across worker processes.
+ * The coordinator talks to each worker over a local socket: it sends a
+ * snapshot of the remaining answers, then work units of candidate guesses,
+ * and reduces the (guess, score) pairs that come back.
+ */
+
+#ifndef GUARD_MINIMAX_WORKERS_H
+#define GUARD_MINIMAX_WORKERS_H
+
+#include <chrono>
+#include <utility>
+#include <vector>
+#include <sys/types.h>
+#include "PerfectMatching.h"
+#include "PerfectMatchingSet.h"
+#include "ScoringPolicy.h"
+
+#define UNITS_PER_WORKER (4)         // Work units per live worker in each decision.
+#define WORKER_TIMEOUT_SECONDS (600) // Default time a worker gets for one unit.
+
+class MinimaxCoordinator {
+private:
+    struct Worker {
+        pid_t pid;       // Worker process, reaped on shutdown or failure.
+        int fd;          // Coordinator's end of the socket, -1 once lost.
+        int unitInFlight;// Work unit the worker is evaluating, or -1.
+        std::chrono::steady_clock::time_point deadline; // When unitInFlight is lost.
+    };
+    std::vector<Worker>* workers;
+    unsigned int decisionId; // Tags messages so stale results are ignored.
+    std::chrono::seconds unitTimeout; // Time a worker gets for one unit.
+
+    void markLost(Worker& worker, std::vector<int>& unitsToAssign);
+public:
+    /**
+     * Start numWorkers worker processes on this host. Each worker is this
+     * same executable, run with --worker and the socket as stdin/stdout.
+     * @param numWorkers Number of worker processes to start.
+     * @param unitTimeoutSeconds Time a worker gets for one unit before it
+     *                           is taken for lost.
+     */
+    MinimaxCoordinator(int numWorkers, int unitTimeoutSeconds = WORKER_TIMEOUT_SECONDS);
+    ~MinimaxCoordinator();
+
+    /**
+     * Get the number of workers which are still reachable.
+     * @return Number of live workers.
+     */
+    int getNumWorkers() const;
+
+    /**
+     * Get the number of work units to split a decision's candidates into,
+     * several per live worker so that they stay busy to the end.
+     * @return Number of work units, or 0 without live workers.
+     */
+    int getNumUnits() const;
+
+    /**
+     * Find the best guess in each chunk of candidates, using the workers.
+     * Units of lost workers, or of workers past their deadline, are
+     * reassigned to the others. Once no workers remain, the units left are
+     * returned for the caller to evaluate on its own threads.
+     * @param possibleAnswers Remaining possibilities for the answer.
+     * @param guessesAlreadyMade Guesses already submitted, never chosen again.
+     * @param chunks Candidate guesses, one work unit per chunk.
+     * @param numChunks Number of chunks.
+     * @param scoringPolicy How to score each candidate's histogram.
+     * @param bestGuesses Gets the best guess of chunk i and its score in slot i.
+     * @param unitsLeft Gets the chunks no worker evaluated, in order.
+     */
+    void evaluateChunks(const PerfectMatchingSet* possibleAnswers,
+                        const PerfectMatchingSet* guessesAlreadyMade,
+                        PerfectMatchingSet** chunks,
+                        int numChunks,
+                        ScoringPolicy scoringPolicy,
+                        std::vector<std::pair<PerfectMatching, long> >* bestGuesses,
+                        std::vector<int>* unitsLeft);
+};
+
+/**
+ * Serve work units from a coordinator until it shuts down or goes away.
+ * @param inputFd Descriptor to read snapshots and work units from.
+ * @param outputFd Descriptor to write results to.
+ */
+void runMinimaxWorker(int inputFd, int outputFd);
+
+#endif
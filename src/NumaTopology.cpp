@@ -0,0 +1,126 @@
+/**
+ * NumaTopology.cpp
+ * Christopher Chute
+ *
+ * NUMA nodes of this machine and the CPUs on each, read from sysfs.
+ */
+
+#include <climits>
+#include <cstdio>
+#include <dirent.h>
+#include <fstream>
+#include <map>
+#include <pthread.h>
+#include <sched.h>
+#include <sstream>
+#include <string>
+#include "NumaTopology.h"
+
+#define NODE_DIRECTORY ("/sys/devices/system/node")
+
+using std::map;
+using std::string;
+using std::vector;
+
+// Parse a sysfs CPU list such as "0-3,8-11".
+static vector<int> parseCpuList(const string& cpuList) {
+    vector<int> cpus;
+    std::stringstream ranges(cpuList);
+    string range;
+    while (std::getline(ranges, range, ',')) {
+        int first;
+        int last;
+        int numRead = sscanf(range.c_str(), "%d-%d", &first, &last);
+        if (numRead == 1) {
+            last = first;
+        } else if (numRead != 2) {
+            continue;
+        }
+        for (int cpu = first; cpu <= last; ++cpu) {
+            cpus.push_back(cpu);
+        }
+    }
+    return cpus;
+}
+
+NumaTopology::NumaTopology() :
+        cpusOfNode(new vector<vector<int> >()),
+        numThreadsPinned(0)
+{
+    // A taskset or cgroup may keep this process off some CPUs.
+    cpu_set_t allowed;
+    CPU_ZERO(&allowed);
+    bool isMasked = sched_getaffinity(0, sizeof(allowed), &allowed) == 0;
+
+    // Nodes may be numbered with gaps, and some have memory but no CPUs.
+    map<int, vector<int> > nodes;
+    DIR* directory = opendir(NODE_DIRECTORY);
+    if (directory) {
+        struct dirent* entry;
+        while ((entry = readdir(directory)) != nullptr) {
+            int node;
+            char rest;
+            if (sscanf(entry->d_name, "node%d%c", &node, &rest) != 1) {
+                continue;
+            }
+            std::ifstream cpuListFile(string(NODE_DIRECTORY) + "/" + entry->d_name + "/cpulist");
+            string cpuList;
+            if (std::getline(cpuListFile, cpuList)) {
+                vector<int> cpus;
+                vector<int> cpusOfNode = parseCpuList(cpuList);
+                for (vector<int>::const_iterator it = cpusOfNode.begin();
+                     it != cpusOfNode.end();
+                     ++it) {
+                    if (!isMasked || (*it < CPU_SETSIZE && CPU_ISSET(*it, &allowed))) {
+                        cpus.push_back(*it);
+                    }
+                }
+                if (!cpus.empty()) {
+                    nodes[node] = cpus;
+                }
+            }
+        }
+        closedir(directory);
+    }
+
+    for (map<int, vector<int> >::const_iterator it = nodes.begin(); it != nodes.end(); ++it) {
+        this->cpusOfNode->push_back(it->second);
+    }
+    if (this->cpusOfNode->empty()) {
+        this->cpusOfNode->push_back(vector<int>());
+    }
+}
+
+NumaTopology::~NumaTopology() {
+    delete this->cpusOfNode;
+}
+
+const NumaTopology& NumaTopology::get() {
+    static const NumaTopology topology;
+    return topology;
+}
+
+int NumaTopology::getNumNodes() const {
+    return int(this->cpusOfNode->size());
+}
+
+const vector<int>& NumaTopology::getCpus(int node) const {
+    return (*this->cpusOfNode)[size_t(node)];
+}
+
+int NumaTopology::getNodeOfThread(int threadIndex) const {
+    return threadIndex % this->getNumNodes();
+}
+
+bool NumaTopology::pinThread() const {
+    if (this->getNumNodes() < 2) {
+        return false;
+    }
+    int threadIndex = int(this->numThreadsPinned++ % unsigned(INT_MAX));
+    const vector<int>& cpus = this->getCpus(this->getNodeOfThread(threadIndex));
+    int cpu = cpus[size_t(threadIndex / this->getNumNodes()) % cpus.size()];
+    cpu_set_t cpuSet;
+    CPU_ZERO(&cpuSet);
+    CPU_SET(cpu, &cpuSet);
+    return pthread_setaffinity_np(pthread_self(), sizeof(cpuSet), &cpuSet) == 0;
+}
@@ -0,0 +1,65 @@
+/**
+ * NumaTopology.h
+ * Christopher Chute
+ *
+ * NUMA nodes of this machine and the CPUs on each, read from sysfs, for
+ * pinning minimax threads so that the data they copy stays node-local.
+ * Only CPUs this process may run on (see sched_getaffinity) are counted.
+ */
+
+#ifndef GUARD_NUMA_TOPOLOGY_H
+#define GUARD_NUMA_TOPOLOGY_H
+
+#include <atomic>
+#include <vector>
+
+class NumaTopology {
+private:
+    std::vector<std::vector<int> >* cpusOfNode; // Allowed CPUs of each node with any.
+    mutable std::atomic<unsigned int> numThreadsPinned; // Threads pinned by this process.
+
+    NumaTopology();
+public:
+    NumaTopology(const NumaTopology&) = delete;
+    NumaTopology& operator=(const NumaTopology&) = delete;
+    ~NumaTopology();
+
+    /**
+     * Get the topology, read from /sys/devices/system/node on first use.
+     * Machines without that directory look like a single node.
+     * @return The topology, shared by all callers.
+     */
+    static const NumaTopology& get();
+
+    /**
+     * Get the number of nodes with CPUs.
+     * @return Number of nodes, at least 1.
+     */
+    int getNumNodes() const;
+
+    /**
+     * Get the CPUs of a node.
+     * @param node Node index, in [0, getNumNodes()).
+     * @return CPU numbers of the node, ascending.
+     */
+    const std::vector<int>& getCpus(int node) const;
+
+    /**
+     * Get the node a thread belongs to, dealing threads to nodes in turn.
+     * @param threadIndex Index of the thread among all those pinned.
+     * @return Node of the thread.
+     */
+    int getNodeOfThread(int threadIndex) const;
+
+    /**
+     * Pin the calling thread to one CPU of its node, dealing the threads of
+     * each node to its CPUs in turn. Threads are counted across the whole
+     * process, so games played in parallel spread over the CPUs rather than
+     * all pinning their first thread to the same one. Does nothing on a
+     * single node.
+     * @return True if the thread was pinned.
+     */
+    bool pinThread() const;
+};
+
+#endif
@@ -0,0 +1,481 @@
+/**
+ * OptimalSolver.cpp
+ * Christopher Chute
+ *
+ * Exact game-tree search for the strategy with the fewest weeks in the
+ * worst case, and then on average, from a given set of remaining answers.
+ */
+
+#include <algorithm>
+#include <climits>
+#include <functional>
+#include <set>
+#include <string>
+#include <thread>
+#include "OptimalSolver.h"
+
+#define NUM_NON_WINNING (PERM_LENGTH - 1) // Responses other than a win: 9 correct can't happen.
+
+using std::max;
+using std::mutex;
+using std::set;
+using std::sort;
+using std::string;
+using std::thread;
+using std::unique_lock;
+using std::vector;
+
+typedef PerfectMatching Pm;
+typedef PackedPerfectMatching PackedPm;
+typedef PerfectMatchingRank PmRank;
+typedef PerfectMatchingSet PmSet;
+typedef TruthBooth Tb;
+
+// Digit at each position of a packed PerfectMatching.
+static void getDigits(PackedPm pm, int* digits) {
+    for (int i = 0; i < PERM_LENGTH; ++i) {
+        digits[i] = int((pm >> (4 * i)) & 0xF);
+    }
+}
+
+// Replace each digit d of pm by labels[d], i.e., rename the men.
+static PackedPm relabel(PackedPm pm, const int* labels) {
+    PackedPm relabeled = 0;
+    for (int i = 0; i < PERM_LENGTH; ++i) {
+        relabeled |= PackedPm(labels[(pm >> (4 * i)) & 0xF]) << (4 * i);
+    }
+    return relabeled;
+}
+
+size_t OptimalSolver::StateHash::operator()(const State& state) const {
+    uint64_t hash = 14695981039346656037ULL;
+    for (State::const_iterator it = state.begin(); it != state.end(); ++it) {
+        hash = (hash ^ *it) * 1099511628211ULL;
+    }
+    return size_t(hash);
+}
+
+OptimalSolver::OptimalSolver(int t, int k) :
+        weekTable(new Table()),
+        guessTable(new Table()),
+        tableLock(new mutex()),
+        numThreads(t > 0 ? t : 1),
+        numExtraCandidates(k),
+        numStatesSolved(0)
+{}
+
+OptimalSolver::~OptimalSolver() {
+    delete this->weekTable;
+    delete this->guessTable;
+    delete this->tableLock;
+}
+
+OptimalSolver::State OptimalSolver::canonicalize(const State& state, PackedPm* pivot) {
+    // Renaming the men so that some answer becomes DIGITS gives a set that
+    // does not depend on the men's names. Of those, keep the smallest.
+    State canonical;
+    for (State::const_iterator p = state.begin(); p != state.end(); ++p) {
+        int digits[PERM_LENGTH];
+        int inverse[PERM_LENGTH];
+        getDigits(*p, digits);
+        for (int i = 0; i < PERM_LENGTH; ++i) {
+            inverse[digits[i]] = i;
+        }
+        State relabeled;
+        relabeled.reserve(state.size());
+        for (State::const_iterator q = state.begin(); q != state.end(); ++q) {
+            relabeled.push_back(relabel(*q, inverse));
+        }
+        sort(relabeled.begin(), relabeled.end());
+        if (canonical.empty() || relabeled < canonical) {
+            canonical.swap(relabeled);
+            *pivot = *p;
+        }
+    }
+    return canonical;
+}
+
+int OptimalSolver::getLowerBound(size_t numAnswers, bool isWeekStart) {
+    // Most answers w weeks can tell apart. In a week the booth splits the
+    // answers in two, then the Perfect Matching wins or leaves one of
+    // NUM_NON_WINNING responses for the following weeks.
+    int weeks = 1;
+    long afterBooth = 1;
+    long atWeekStart = 2;
+    while ((isWeekStart ? atWeekStart : afterBooth) < long(numAnswers)) {
+        ++weeks;
+        afterBooth = 1 + NUM_NON_WINNING * atWeekStart;
+        atWeekStart = 2 * afterBooth;
+    }
+    return weeks;
+}
+
+bool OptimalSolver::findEntry(const Table* table, const State& state, Entry* entry) const {
+    unique_lock<mutex> guard(*this->tableLock);
+    Table::const_iterator it = table->find(state);
+    if (it == table->end()) {
+        return false;
+    }
+    *entry = it->second;
+    return true;
+}
+
+void OptimalSolver::storeEntry(Table* table, const State& state, const Entry& entry) {
+    unique_lock<mutex> guard(*this->tableLock);
+    if (table->insert(Table::value_type(state, entry)).second) {
+        ++this->numStatesSolved;
+    }
+}
+
+void OptimalSolver::evaluateTruthBooths(const State& state,
+                                        const vector<PackedPm>* truthBooths,
+                                        size_t first,
+                                        size_t stride,
+                                        Entry* best,
+                                        mutex* bestLock) {
+    for (size_t t = first; t < truthBooths->size(); t += stride) {
+        PackedPm truthBooth = (*truthBooths)[t];
+        int index = int(truthBooth >> 4);
+        PackedPm digit = truthBooth & 0xF;
+        State larger;
+        State smaller;
+        for (State::const_iterator it = state.begin(); it != state.end(); ++it) {
+            (((*it >> (4 * index)) & 0xF) == digit ? larger : smaller).push_back(*it);
+        }
+        if (larger.size() < smaller.size()) {
+            larger.swap(smaller);
+        }
+
+        int bound;
+        {
+            unique_lock<mutex> guard(*bestLock);
+            bound = best->value._worstWeeks;
+        }
+        if (getLowerBound(larger.size(), false) > bound) {
+            continue;
+        }
+        OptimalValue largerValue = this->solveGuess(larger);
+        if (largerValue._worstWeeks > bound) {
+            continue;
+        }
+        OptimalValue smallerValue = this->solveGuess(smaller);
+        OptimalValue value(max(largerValue._worstWeeks, smallerValue._worstWeeks),
+                           largerValue._totalWeeks + smallerValue._totalWeeks);
+
+        // Ties go to the lowest booth, whichever thread gets there first.
+        unique_lock<mutex> guard(*bestLock);
+        if (value < best->value ||
+                (!(best->value < value) && best->hasMove && truthBooth < best->move)) {
+            best->value = value;
+            best->move = truthBooth;
+            best->hasMove = true;
+        }
+    }
+}
+
+void OptimalSolver::evaluateGuesses(const State& state,
+                                    const vector<PackedPm>& guesses,
+                                    Entry* best) {
+    // Guesses splitting the answers the same way are interchangeable. Try
+    // the rest from the lowest bound, then the smallest largest response.
+    set<string> responses;
+    vector<std::pair<std::pair<int, size_t>, size_t> > order;
+    for (size_t g = 0; g < guesses.size(); ++g) {
+        string response(state.size(), '0');
+        size_t numGivenResponse[PERM_LENGTH + 1] = { 0 };
+        for (size_t a = 0; a < state.size(); ++a) {
+            int numCorrect = numInCommonPacked(guesses[g], state[a]);
+            response[a] = char('0' + numCorrect);
+            ++numGivenResponse[numCorrect];
+        }
+        if (!responses.insert(response).second) {
+            continue;
+        }
+        if (numGivenResponse[response[0] - '0'] == state.size()) {
+            continue; // Tells the answers nothing.
+        }
+        int bound = numGivenResponse[PERM_LENGTH] > 0 ? 1 : 0;
+        size_t largest = 0;
+        for (int r = 0; r < PERM_LENGTH; ++r) {
+            if (numGivenResponse[r] > 0) {
+                bound = max(bound, 1 + getLowerBound(numGivenResponse[r], true));
+                largest = max(largest, numGivenResponse[r]);
+            }
+        }
+        order.push_back(std::make_pair(std::make_pair(bound, largest), g));
+    }
+    sort(order.begin(), order.end());
+
+    for (size_t o = 0; o < order.size(); ++o) {
+        if (order[o].first.first > best->value._worstWeeks) {
+            break;
+        }
+        PackedPm guess = guesses[order[o].second];
+        vector<State> children(PERM_LENGTH + 1);
+        for (State::const_iterator it = state.begin(); it != state.end(); ++it) {
+            children[numInCommonPacked(guess, *it)].push_back(*it);
+        }
+        bool isWin = !children[PERM_LENGTH].empty();
+        children.pop_back();
+        sort(children.begin(), children.end(),
+             [](const State& a, const State& b) { return a.size() > b.size(); });
+
+        // Every answer takes this week, and the others the weeks after.
+        OptimalValue value(isWin ? 1 : 0, long(state.size()));
+        for (vector<State>::const_iterator child = children.begin();
+             child != children.end() && !child->empty() &&
+                     value._worstWeeks <= best->value._worstWeeks;
+             ++child) {
+            OptimalValue childValue = this->solveWeek(*child, false);
+            value._worstWeeks = max(value._worstWeeks, 1 + childValue._worstWeeks);
+            value._totalWeeks += childValue._totalWeeks;
+        }
+        if (value._worstWeeks <= best->value._worstWeeks &&
+                (value < best->value || (!(best->value < value) && guess < best->move))) {
+            best->value = value;
+            best->move = guess;
+            best->hasMove = true;
+        }
+    }
+}
+
+vector<PackedPm> OptimalSolver::getExtraCandidates(const State& state) const {
+    // Non-answers one swap from an answer, rather than all of the universe:
+    // they agree with that answer in all but two pairs, so they split it
+    // from the answers closest to it. Keep those with the smallest largest
+    // response, then the smallest sum of squared responses, i.e., expected
+    // number left.
+    vector<PackedPm> neighbors;
+    neighbors.reserve(state.size() * PERM_LENGTH * (PERM_LENGTH - 1) / 2);
+    for (State::const_iterator it = state.begin(); it != state.end(); ++it) {
+        for (int i = 0; i < PERM_LENGTH; ++i) {
+            for (int j = i + 1; j < PERM_LENGTH; ++j) {
+                PackedPm digitI = (*it >> (4 * i)) & 0xF;
+                PackedPm digitJ = (*it >> (4 * j)) & 0xF;
+                PackedPm mask = (PackedPm(0xF) << (4 * i)) | (PackedPm(0xF) << (4 * j));
+                neighbors.push_back((*it & ~mask) | (digitJ << (4 * i)) | (digitI << (4 * j)));
+            }
+        }
+    }
+    sort(neighbors.begin(), neighbors.end());
+    neighbors.erase(std::unique(neighbors.begin(), neighbors.end()), neighbors.end());
+
+    typedef std::pair<std::pair<size_t, size_t>, PackedPm> Scored;
+    vector<Scored> best;
+    for (vector<PackedPm>::const_iterator g = neighbors.begin(); g != neighbors.end(); ++g) {
+        size_t numGivenResponse[PERM_LENGTH + 1] = { 0 };
+        for (State::const_iterator it = state.begin(); it != state.end(); ++it) {
+            ++numGivenResponse[numInCommonPacked(*g, *it)];
+        }
+        if (numGivenResponse[PERM_LENGTH] > 0) {
+            continue;
+        }
+        size_t largest = 0;
+        size_t sumOfSquares = 0;
+        for (int r = 0; r < PERM_LENGTH; ++r) {
+            largest = max(largest, numGivenResponse[r]);
+            sumOfSquares += numGivenResponse[r] * numGivenResponse[r];
+        }
+        Scored scored(std::make_pair(largest, sumOfSquares), *g);
+        if (best.size() < size_t(this->numExtraCandidates) || scored < best.back()) {
+            best.insert(std::upper_bound(best.begin(), best.end(), scored), scored);
+            if (best.size() > size_t(this->numExtraCandidates)) {
+                best.pop_back();
+            }
+        }
+    }
+
+    vector<PackedPm> candidates;
+    for (vector<Scored>::const_iterator it = best.begin(); it != best.end(); ++it) {
+        candidates.push_back(it->second);
+    }
+    return candidates;
+}
+
+OptimalValue OptimalSolver::solveWeek(const State& state, bool isParallel) {
+    if (state.size() == 1) {
+        return OptimalValue(1, 1);
+    }
+    PackedPm pivot;
+    State canonical = canonicalize(state, &pivot);
+    Entry entry;
+    if (this->findEntry(this->weekTable, canonical, &entry)) {
+        return entry.value;
+    }
+
+    // One booth per distinct split of the answers, most even first. Yes and
+    // no swapped is the same split.
+    set<string> splits;
+    vector<std::pair<size_t, PackedPm> > balancedBooths;
+    for (int index = 0; index < PERM_LENGTH; ++index) {
+        for (PackedPm digit = 0; digit < PERM_LENGTH; ++digit) {
+            string split(canonical.size(), '0');
+            size_t numMatches = 0;
+            for (size_t a = 0; a < canonical.size(); ++a) {
+                if (((canonical[a] >> (4 * index)) & 0xF) == digit) {
+                    split[a] = '1';
+                    ++numMatches;
+                }
+            }
+            if (numMatches == 0 || numMatches == canonical.size()) {
+                continue;
+            }
+            if (split[0] == '0') {
+                for (string::iterator it = split.begin(); it != split.end(); ++it) {
+                    *it = *it == '0' ? '1' : '0';
+                }
+            }
+            if (splits.insert(split).second) {
+                size_t imbalance = numMatches * 2 > canonical.size() ?
+                        numMatches * 2 - canonical.size() : canonical.size() - numMatches * 2;
+                balancedBooths.push_back(std::make_pair(imbalance, PackedPm(16 * index) + digit));
+            }
+        }
+    }
+    sort(balancedBooths.begin(), balancedBooths.end());
+    vector<PackedPm> truthBooths;
+    for (size_t t = 0; t < balancedBooths.size(); ++t) {
+        truthBooths.push_back(balancedBooths[t].second);
+    }
+
+    entry.value = OptimalValue(INT_MAX, LONG_MAX);
+    if (truthBooths.empty()) {
+        // No booth tells these answers apart; any booth will do.
+        entry.value = this->solveGuess(canonical);
+    } else if (isParallel && this->numThreads > 1) {
+        mutex bestLock;
+        vector<thread> threads;
+        for (int id = 0; id < this->numThreads; ++id) {
+            threads.push_back(thread(&OptimalSolver::evaluateTruthBooths,
+                                     this,
+                                     std::cref(canonical),
+                                     &truthBooths,
+                                     size_t(id),
+                                     size_t(this->numThreads),
+                                     &entry,
+                                     &bestLock));
+        }
+        for (vector<thread>::iterator it = threads.begin(); it != threads.end(); ++it) {
+            it->join();
+        }
+    } else {
+        mutex bestLock;
+        this->evaluateTruthBooths(canonical, &truthBooths, 0, 1, &entry, &bestLock);
+    }
+
+    this->storeEntry(this->weekTable, canonical, entry);
+    return entry.value;
+}
+
+OptimalValue OptimalSolver::solveGuess(const State& state) {
+    if (state.size() == 1) {
+        return OptimalValue(1, 1);
+    }
+    PackedPm pivot;
+    State canonical = canonicalize(state, &pivot);
+    Entry entry;
+    if (this->findEntry(this->guessTable, canonical, &entry)) {
+        return entry.value;
+    }
+
+    // Answers first. Others can only help when the answers leave a gap to
+    // the lower bound, so only then are the best of them scanned for.
+    entry.value = OptimalValue(INT_MAX, LONG_MAX);
+    this->evaluateGuesses(canonical, canonical, &entry);
+    if (entry.value._worstWeeks > getLowerBound(canonical.size(), false) &&
+            this->numExtraCandidates > 0) {
+        this->evaluateGuesses(canonical, this->getExtraCandidates(canonical), &entry);
+    }
+
+    this->storeEntry(this->guessTable, canonical, entry);
+    return entry.value;
+}
+
+OptimalSolver::State OptimalSolver::getState(const PmSet* possibleAnswers) {
+    State state;
+    state.reserve(possibleAnswers->size());
+    for (PmSet::const_iterator it = possibleAnswers->begin(); it != possibleAnswers->end(); ++it) {
+        state.push_back(packPerfectMatching(*it));
+    }
+    sort(state.begin(), state.end());
+    return state;
+}
+
+uint64_t OptimalSolver::getTreeKey(const State& state) {
+    // Same key a game computes from its own set of remaining answers.
+    vector<PmRank> ranks;
+    for (State::const_iterator it = state.begin(); it != state.end(); ++it) {
+        ranks.push_back(getRank(unpackPerfectMatching(*it)));
+    }
+    sort(ranks.begin(), ranks.end());
+    PmSet possibleAnswers;
+    for (vector<PmRank>::const_iterator it = ranks.begin(); it != ranks.end(); ++it) {
+        possibleAnswers.addRank(*it);
+    }
+    return possibleAnswers.hash();
+}
+
+void OptimalSolver::addWeekMoves(const State& state, DecisionTree* tree) const {
+    if (state.size() <= 1) {
+        return;
+    }
+    PackedPm pivot;
+    Entry entry;
+    if (!this->findEntry(this->weekTable, canonicalize(state, &pivot), &entry)) {
+        return;
+    }
+    if (!entry.hasMove) {
+        this->addGuessMoves(state, tree);
+        return;
+    }
+
+    // Undo the renaming: digit d of the canonical state is digit pivot[d].
+    int pivotDigits[PERM_LENGTH];
+    getDigits(pivot, pivotDigits);
+    int index = int(entry.move >> 4);
+    int digit = pivotDigits[entry.move & 0xF];
+    tree->addTruthBooth(getTreeKey(state), state.size(), Tb(index, char('0' + digit)));
+
+    State yes;
+    State no;
+    for (State::const_iterator it = state.begin(); it != state.end(); ++it) {
+        (int((*it >> (4 * index)) & 0xF) == digit ? yes : no).push_back(*it);
+    }
+    this->addGuessMoves(yes, tree);
+    this->addGuessMoves(no, tree);
+}
+
+void OptimalSolver::addGuessMoves(const State& state, DecisionTree* tree) const {
+    if (state.size() <= 1) {
+        return;
+    }
+    PackedPm pivot;
+    Entry entry;
+    if (!this->findEntry(this->guessTable, canonicalize(state, &pivot), &entry)) {
+        return;
+    }
+
+    int pivotDigits[PERM_LENGTH];
+    getDigits(pivot, pivotDigits);
+    PackedPm guess = relabel(entry.move, pivotDigits);
+    tree->addPerfectMatching(getTreeKey(state), state.size(), unpackPerfectMatching(guess));
+
+    vector<State> children(PERM_LENGTH);
+    for (State::const_iterator it = state.begin(); it != state.end(); ++it) {
+        int numCorrect = numInCommonPacked(guess, *it);
+        if (numCorrect < PERM_LENGTH) {
+            children[numCorrect].push_back(*it);
+        }
+    }
+    for (vector<State>::const_iterator child = children.begin(); child != children.end(); ++child) {
+        this->addWeekMoves(*child, tree);
+    }
+}
+
+OptimalValue OptimalSolver::solve(const PmSet* possibleAnswers) {
+    return this->solveWeek(getState(possibleAnswers), true);
+}
+
+void OptimalSolver::addMoves(const PmSet* possibleAnswers, DecisionTree* tree) const {
+    this->addWeekMoves(getState(possibleAnswers), tree);
+}
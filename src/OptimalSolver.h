@@ -0,0 +1,116 @@
+/**
+ * OptimalSolver.h
+ * Christopher Chute
+ *
+ * Exact game-tree search for the strategy with the fewest weeks in the
+ * worst case, and then on average, from a given set of remaining answers.
+ * States are reduced by relabeling the men, which leaves every Truth Booth
+ * and Perfect Matching response unchanged, and memoized in transposition
+ * tables; moves are pruned by a lower bound on the weeks a state needs.
+ */
+
+#ifndef GUARD_OPTIMAL_SOLVER_H
+#define GUARD_OPTIMAL_SOLVER_H
+
+#include <atomic>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+#include "DecisionTree.h"
+#include "PerfectMatching.h"
+#include "PerfectMatchingSet.h"
+
+/**
+ * Number of weeks a strategy takes from some state, over its answers.
+ */
+struct OptimalValue {
+    int _worstWeeks;  // Weeks needed for the hardest answer.
+    long _totalWeeks; // Weeks summed over all answers.
+    OptimalValue() : _worstWeeks(0), _totalWeeks(0) {}
+    OptimalValue(int worstWeeks, long totalWeeks) :
+            _worstWeeks(worstWeeks), _totalWeeks(totalWeeks) {}
+    bool operator<(const OptimalValue& that) const {
+        return this->_worstWeeks < that._worstWeeks ||
+               (this->_worstWeeks == that._worstWeeks && this->_totalWeeks < that._totalWeeks);
+    }
+};
+
+class OptimalSolver {
+private:
+    typedef std::vector<PackedPerfectMatching> State; // Sorted remaining answers.
+
+    struct StateHash {
+        size_t operator()(const State& state) const;
+    };
+
+    // Best value of a canonical state, and the move achieving it. Truth
+    // Booths are stored as 16 * index + digit.
+    struct Entry {
+        OptimalValue value;
+        PackedPerfectMatching move;
+        bool hasMove;
+        Entry() : move(0), hasMove(false) {}
+    };
+    typedef std::unordered_map<State, Entry, StateHash> Table;
+
+    Table* weekTable;       // States at the start of a week, before the booth.
+    Table* guessTable;      // States after the booth, before the Perfect Matching.
+    std::mutex* tableLock;  // Guards both tables.
+    int numThreads;         // Threads sharing the subtrees of the root.
+    int numExtraCandidates; // Non-answers tried as Perfect Matchings per state.
+    std::atomic<long> numStatesSolved;
+
+    static State canonicalize(const State& state, PackedPerfectMatching* pivot);
+    static int getLowerBound(size_t numAnswers, bool isWeekStart);
+    bool findEntry(const Table* table, const State& state, Entry* entry) const;
+    void storeEntry(Table* table, const State& state, const Entry& entry);
+    void evaluateTruthBooths(const State& state,
+                             const std::vector<PackedPerfectMatching>* truthBooths,
+                             size_t first,
+                             size_t stride,
+                             Entry* best,
+                             std::mutex* bestLock);
+    void evaluateGuesses(const State& state,
+                         const std::vector<PackedPerfectMatching>& guesses,
+                         Entry* best);
+    std::vector<PackedPerfectMatching> getExtraCandidates(const State& state) const;
+    OptimalValue solveWeek(const State& state, bool isParallel);
+    OptimalValue solveGuess(const State& state);
+    void addWeekMoves(const State& state, DecisionTree* tree) const;
+    void addGuessMoves(const State& state, DecisionTree* tree) const;
+    static State getState(const PerfectMatchingSet* possibleAnswers);
+    static uint64_t getTreeKey(const State& state);
+public:
+    /**
+     * Create a solver with empty transposition tables.
+     * @param numThreads Threads to search the subtrees of the root with.
+     * @param numExtraCandidates Perfect Matchings outside the remaining
+     * answers tried in each state, the best by minimax score of those one
+     * swap from an answer. The search is exact over these candidates and
+     * the remaining answers.
+     */
+    OptimalSolver(int numThreads, int numExtraCandidates);
+    ~OptimalSolver();
+
+    /**
+     * Find the value of optimal play from the start of a week.
+     * @param possibleAnswers Remaining answers at the start of the week.
+     * @return Worst-case and total weeks, counted from this week.
+     */
+    OptimalValue solve(const PerfectMatchingSet* possibleAnswers);
+
+    /**
+     * Add the optimal moves for every state reachable from a solved one.
+     * @param possibleAnswers Remaining answers, already passed to solve.
+     * @param tree Where the moves go, keyed by PerfectMatchingSet::hash.
+     */
+    void addMoves(const PerfectMatchingSet* possibleAnswers, DecisionTree* tree) const;
+
+    /**
+     * Get the number of distinct canonical states solved so far.
+     * @return Number of entries in the transposition tables.
+     */
+    long getNumStatesSolved() const { return this->numStatesSolved; }
+};
+
+#endif
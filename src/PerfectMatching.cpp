@@ -15,3 +15,44 @@ int numInCommon(PerfectMatching const& pm1, PerfectMatching const& pm2) {
             ++numInCommon;
     return numInCommon;
 }
+
+bool isPerfectMatching(PerfectMatching const& pm) {
+    if (pm.size() != PERM_LENGTH)
+        return false;
+
+    unsigned int seen = 0;
+    for (unsigned int i = 0; i < pm.size(); ++i) {
+        if (pm[i] < '0' || pm[i] > '9' || (seen & (1u << (pm[i] - '0'))))
+            return false;
+        seen |= 1u << (pm[i] - '0');
+    }
+    return true;
+}
+
+PerfectMatchingRank getRank(PerfectMatching const& pm) {
+    // Lehmer code: count smaller digits to the right of each position,
+    // weighted by the factorial of the number of positions to the right.
+    PerfectMatchingRank rank = 0;
+    for (int i = 0; i < PERM_LENGTH; ++i) {
+        int numSmallerToRight = 0;
+        for (int j = i + 1; j < PERM_LENGTH; ++j)
+            if (pm[j] < pm[i])
+                ++numSmallerToRight;
+        rank = rank * (PERM_LENGTH - i) + numSmallerToRight;
+    }
+    return rank;
+}
+
+PackedPerfectMatching packPerfectMatching(PerfectMatching const& pm) {
+    PackedPerfectMatching packed = 0;
+    for (int i = 0; i < PERM_LENGTH; ++i)
+        packed |= PackedPerfectMatching(pm[i] - '0') << (4 * i);
+    return packed;
+}
+
+PerfectMatching unpackPerfectMatching(PackedPerfectMatching packed) {
+    PerfectMatching pm(PERM_LENGTH, '0');
+    for (int i = 0; i < PERM_LENGTH; ++i)
+        pm[i] = char('0' + ((packed >> (4 * i)) & 0xF));
+    return pm;
+}
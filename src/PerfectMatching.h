@@ -8,7 +8,16 @@
 #ifndef GUARD_PERFECT_MATCHING_H
 #define GUARD_PERFECT_MATCHING_H
 
+#include <cstdint>
+#include <string>
+
+#define DIGITS ("0123456789")   // Available digits for a permutation.
+#define NUM_PERMS (3628800)     // Number of permutations of DIGITS, i.e., 10!.
+#define PERM_LENGTH (10)        // Number of elements in a permutation.
+
 typedef std::string PerfectMatching;
+typedef uint32_t PerfectMatchingRank; // Lexicographic index among all NUM_PERMS.
+typedef uint64_t PackedPerfectMatching; // Nibble i holds the digit at position i.
 
 /**
  * Get the number of positions in which two PerfectMatchings share
@@ -19,4 +28,48 @@ typedef std::string PerfectMatching;
  */
 int numInCommon(PerfectMatching const& pm1, PerfectMatching const& pm2);
 
+/**
+ * Check whether a string is a permutation of DIGITS.
+ * @param pm String to check.
+ * @return True if pm contains each of the digits 0 through 9 exactly once.
+ */
+bool isPerfectMatching(PerfectMatching const& pm);
+
+/**
+ * Get the lexicographic rank of a PerfectMatching, i.e., its position in
+ * the sequence generated by next_permutation starting from DIGITS.
+ * @param pm PerfectMatching to rank. Must satisfy isPerfectMatching.
+ * @return Rank of pm, in the range [0, NUM_PERMS).
+ */
+PerfectMatchingRank getRank(PerfectMatching const& pm);
+
+/**
+ * Pack a PerfectMatching into one nibble per position, so two packed
+ * matchings can be compared with a handful of word operations.
+ * @param pm PerfectMatching to pack. Must satisfy isPerfectMatching.
+ * @return Packed form of pm.
+ */
+PackedPerfectMatching packPerfectMatching(PerfectMatching const& pm);
+
+/**
+ * Unpack a PerfectMatching packed by packPerfectMatching.
+ * @param packed Packed PerfectMatching.
+ * @return The PerfectMatching as a string of digits.
+ */
+PerfectMatching unpackPerfectMatching(PackedPerfectMatching packed);
+
+/**
+ * Same as numInCommon, on packed PerfectMatchings.
+ * @param pm1 First packed PerfectMatching to compare.
+ * @param pm2 Second packed PerfectMatching to compare.
+ * @return Number of positions in which pm1 has same digit as pm2.
+ */
+inline int numInCommonPacked(PackedPerfectMatching pm1, PackedPerfectMatching pm2) {
+    // Fold each nibble of the difference onto its lowest bit, then count
+    // the positions that differ.
+    PackedPerfectMatching diff = pm1 ^ pm2;
+    diff = (diff | diff >> 1 | diff >> 2 | diff >> 3) & 0x1111111111ULL;
+    return PERM_LENGTH - __builtin_popcountll(diff);
+}
+
 #endif
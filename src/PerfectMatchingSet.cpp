@@ -9,75 +9,399 @@
 #include <cassert>
 #include <fstream>
 #include "PerfectMatchingSet.h"
+#include "PerfectMatchingUniverse.h"
 
+using std::fill;
+using std::find;
 using std::ifstream;
 using std::string;
 using std::vector;
 
 typedef PerfectMatching Pm;
+typedef PerfectMatchingRank PmRank;
 typedef TruthBooth Tb;
 
-PerfectMatchingSet::PerfectMatchingSet(){
-    this->data = new vector<Pm>();
+PerfectMatchingSet::const_iterator::const_iterator(const Pm* p, const uint64_t* b, PmRank r) :
+        perms(p),
+        pos(nullptr),
+        bitset(b),
+        bit(r)
+{
+    if (r < NUM_PERMS && !((b[r / 64] >> (r % 64)) & 1)) {
+        this->advanceInBitset();
+    }
+}
+
+void PerfectMatchingSet::const_iterator::advanceInBitset() {
+    size_t w = size_t(this->bit + 1) / 64;
+    if (w == NUM_BITSET_WORDS) {
+        this->bit = NUM_PERMS;
+        return;
+    }
+    uint64_t word = this->bitset[w] & (~0ULL << ((this->bit + 1) % 64));
+    while (!word) {
+        if (++w == NUM_BITSET_WORDS) {
+            this->bit = NUM_PERMS;
+            return;
+        }
+        word = this->bitset[w];
+    }
+    this->bit = PmRank(w * 64 + size_t(__builtin_ctzll(word)));
+}
+
+PerfectMatchingSet::const_iterator&
+PerfectMatchingSet::const_iterator::operator+=(difference_type n) {
+    if (!this->bitset) {
+        this->pos += n;
+        return *this;
+    }
+    while (n-- > 0) {
+        this->advanceInBitset();
+    }
+    return *this;
+}
+
+// Number of set bits below bit r.
+static std::ptrdiff_t countBitsBelow(const uint64_t* bitset, PmRank r) {
+    std::ptrdiff_t count = 0;
+    for (size_t w = 0; w < r / 64; ++w) {
+        count += __builtin_popcountll(bitset[w]);
+    }
+    if (r % 64) {
+        count += __builtin_popcountll(bitset[r / 64] & ((1ULL << (r % 64)) - 1));
+    }
+    return count;
 }
 
-PerfectMatchingSet::PerfectMatchingSet(iterator b, iterator e) {
-    this->data = new vector<Pm>(b, e);
+PerfectMatchingSet::const_iterator::difference_type
+PerfectMatchingSet::const_iterator::operator-(const const_iterator& that) const {
+    if (!this->bitset) {
+        return this->pos - that.pos;
+    }
+    return countBitsBelow(this->bitset, this->bit) - countBitsBelow(this->bitset, that.bit);
+}
+
+PerfectMatchingSet::PerfectMatchingSet() :
+        perms(PerfectMatchingUniverse::get().getPerms()),
+        layout(RANK_LAYOUT),
+        first(nullptr),
+        last(nullptr),
+        writable(nullptr),
+        bitset(nullptr),
+        bitsetSize(0),
+        packed(nullptr),
+        isShared(false),
+        data(new vector<PmRank>()),
+        words(nullptr),
+        arena(nullptr)
+{}
+
+PerfectMatchingSet::PerfectMatchingSet(ScratchArena* a) :
+        perms(PerfectMatchingUniverse::get().getPerms()),
+        layout(RANK_LAYOUT),
+        first(nullptr),
+        last(nullptr),
+        writable(nullptr),
+        bitset(nullptr),
+        bitsetSize(0),
+        packed(nullptr),
+        isShared(false),
+        data(nullptr),
+        words(nullptr),
+        arena(a)
+{}
+
+PerfectMatchingSet::PerfectMatchingSet(iterator b, iterator e) :
+        perms(PerfectMatchingUniverse::get().getPerms()),
+        layout(RANK_LAYOUT),
+        first(nullptr),
+        last(nullptr),
+        writable(nullptr),
+        bitset(nullptr),
+        bitsetSize(0),
+        packed(nullptr),
+        isShared(false),
+        data(new vector<PmRank>()),
+        words(nullptr),
+        arena(nullptr)
+{
+    size_t numRanks = size_t(e - b);
+    if (b.isOverBitset() && numRanks >= DENSE_SET_MIN_SIZE) {
+        // Copy a dense set as a bitset, so it stays in increasing order.
+        uint64_t* bits = this->allocateWords(NUM_BITSET_WORDS);
+        fill(bits, bits + NUM_BITSET_WORDS, 0);
+        for (iterator it = b; it != e; ++it) {
+            bits[it.rank() / 64] |= 1ULL << (it.rank() % 64);
+        }
+        this->bitset = bits;
+        this->bitsetSize = numRanks;
+        this->layout = BITSET_LAYOUT;
+        return;
+    }
+
+    this->data->reserve(numRanks);
+    for (iterator it = b; it != e; ++it) {
+        this->data->push_back(it.rank());
+    }
+    this->first = this->writable = this->data->data();
+    this->last = this->first + this->data->size();
+    this->adaptLayout();
 }
 
 PerfectMatchingSet::~PerfectMatchingSet() {
     delete this->data;
+    delete this->words;
+}
+
+PmRank* PerfectMatchingSet::allocateRanks(size_t numRanks) {
+    if (this->arena) {
+        return this->arena->allocateArray<PmRank>(numRanks);
+    }
+    if (!this->data) {
+        this->data = new vector<PmRank>();
+    }
+    this->data->resize(numRanks);
+    return this->data->data();
+}
+
+uint64_t* PerfectMatchingSet::allocateWords(size_t numWords) {
+    if (this->arena) {
+        return this->arena->allocateArray<uint64_t>(numWords);
+    }
+    if (!this->words) {
+        this->words = new vector<uint64_t>();
+    }
+    this->words->resize(numWords);
+    return this->words->data();
+}
+
+void PerfectMatchingSet::adaptLayout() {
+    if (this->layout == BITSET_LAYOUT && this->bitsetSize < DENSE_SET_MIN_SIZE) {
+        this->convertToRanks();
+    }
+    if (this->layout == RANK_LAYOUT && this->writable && this->size() <= PACKED_SET_MAX_SIZE) {
+        this->convertToPacked();
+    }
+}
+
+void PerfectMatchingSet::convertToRanks() {
+    PmRank* out = this->allocateRanks(this->bitsetSize);
+    PmRank* newFirst = out;
+    for (size_t w = 0; w < NUM_BITSET_WORDS; ++w) {
+        for (uint64_t word = this->bitset[w]; word; word &= word - 1) {
+            *out++ = PmRank(w * 64 + size_t(__builtin_ctzll(word)));
+        }
+    }
+    assert(size_t(out - newFirst) == this->bitsetSize);
+
+    if (this->words) {
+        // A sparse set should not keep holding a bitset's worth of memory.
+        this->words->clear();
+        this->words->shrink_to_fit();
+    }
+    this->first = this->writable = newFirst;
+    this->last = out;
+    this->bitset = nullptr;
+    this->bitsetSize = 0;
+    this->layout = RANK_LAYOUT;
+}
+
+void PerfectMatchingSet::convertToPacked() {
+    PackedPerfectMatching* out = this->allocateWords(this->size());
+    for (const PmRank* it = this->first; it != this->last; ++it) {
+        *out++ = packPerfectMatching(this->perms[*it]);
+    }
+    this->packed = out - this->size();
+    this->layout = PACKED_LAYOUT;
 }
 
 void PerfectMatchingSet::add(const PerfectMatching& p) {
-    this->data->push_back(p);
+    assert(isPerfectMatching(p));
+    this->addRank(getRank(p));
+}
+
+void PerfectMatchingSet::addRank(PmRank rank) {
+    // Sets are only grown one by one while small, so keep plain ranks.
+    if (this->layout == BITSET_LAYOUT) {
+        this->convertToRanks();
+    }
+    this->packed = nullptr;
+    this->layout = RANK_LAYOUT;
+
+    if (!this->data) {
+        // Views and arena storage can't grow, so move to the heap.
+        this->data = new vector<PmRank>(this->first, this->last);
+    } else if (!this->writable || this->writable != this->data->data()) {
+        this->data->assign(this->first, this->last);
+    }
+    this->data->push_back(rank);
+    this->first = this->writable = this->data->data();
+    this->last = this->first + this->data->size();
+    this->isShared = false;
 }
 
 PerfectMatchingSet::iterator PerfectMatchingSet::begin() const {
-    return this->data->begin();
+    if (this->layout == BITSET_LAYOUT) {
+        return iterator(this->perms, this->bitset, 0);
+    }
+    return iterator(this->perms, this->first);
 }
 
 bool PerfectMatchingSet::contains(const PerfectMatching& p) const {
-    return find(this->begin(), this->end(), p) != this->end();
+    if (this->layout == RANK_LAYOUT) {
+        return find(this->begin(), this->end(), p) != this->end();
+    }
+    if (!isPerfectMatching(p)) {
+        return false;
+    }
+    if (this->layout == BITSET_LAYOUT) {
+        PmRank rank = getRank(p);
+        return (this->bitset[rank / 64] >> (rank % 64)) & 1;
+    }
+    PackedPerfectMatching pm = packPerfectMatching(p);
+    return find(this->packed, this->packed + this->size(), pm) != this->packed + this->size();
 }
 
 PerfectMatchingSet::iterator PerfectMatchingSet::end() const {
-    return this->data->end();
+    if (this->layout == BITSET_LAYOUT) {
+        return iterator(this->perms, this->bitset, NUM_PERMS);
+    }
+    return iterator(this->perms, this->last);
 }
 
-void PerfectMatchingSet::filter(const PerfectMatching& p, int n) {
-    vector<Pm>* newData = new vector<Pm>();
-    for (PerfectMatchingSet::iterator it = this->begin(); it != this->end(); ++it) {
-        if (numInCommon(p, *it) == n) {
-            newData->push_back(*it);
+template<typename Predicate>
+void PerfectMatchingSet::retainIf(Predicate shouldRetain) {
+    if (this->layout == BITSET_LAYOUT) {
+        size_t numRetained = 0;
+        for (size_t w = 0; w < NUM_BITSET_WORDS; ++w) {
+            uint64_t retained = this->bitset[w];
+            for (uint64_t word = retained; word; word &= word - 1) {
+                int b = __builtin_ctzll(word);
+                if (!shouldRetain(this->perms[w * 64 + size_t(b)])) {
+                    retained &= ~(1ULL << b);
+                }
+            }
+            this->bitset[w] = retained;
+            numRetained += size_t(__builtin_popcountll(retained));
         }
+        this->bitsetSize = numRetained;
+        this->adaptLayout();
+        return;
     }
 
-    delete this->data;
-    this->data = newData;
+    if (this->isShared && this->size() >= DENSE_SET_MIN_SIZE) {
+        // First filter of a large view: most survivors fit a bitset best.
+        uint64_t* bits = this->allocateWords(NUM_BITSET_WORDS);
+        fill(bits, bits + NUM_BITSET_WORDS, 0);
+        size_t numRetained = 0;
+        for (const PmRank* it = this->first; it != this->last; ++it) {
+            if (shouldRetain(this->perms[*it])) {
+                bits[*it / 64] |= 1ULL << (*it % 64);
+                ++numRetained;
+            }
+        }
+        if (this->data) {
+            this->data->clear();
+        }
+        this->first = this->last = this->writable = nullptr;
+        this->bitset = bits;
+        this->bitsetSize = numRetained;
+        this->layout = BITSET_LAYOUT;
+        this->isShared = false;
+        this->adaptLayout();
+        return;
+    }
+
+    PmRank* out = this->writable;
+    if (!out) {
+        // First filter of a view: the survivors need storage of their own.
+        out = this->allocateRanks(this->size());
+    }
+
+    // Filtering in place is safe since out never passes the read position.
+    PmRank* newFirst = out;
+    for (const PmRank* it = this->first; it != this->last; ++it) {
+        if (shouldRetain(this->perms[*it])) {
+            *out++ = *it;
+        }
+    }
+
+    if (this->data && newFirst == this->data->data()) {
+        this->data->resize(size_t(out - newFirst));
+    }
+    this->first = this->writable = newFirst;
+    this->last = out;
+    this->isShared = false;
+    this->adaptLayout();
 }
 
-void PerfectMatchingSet::filter(const Tb& m, bool isMatch) {
-    vector<Pm>* newData = new vector<Pm>();
-    for (PerfectMatchingSet::iterator it = this->begin(); it != this->end(); ++it) {
-        if (isMatch == ((*it)[m.index] == m.charAtIndex)) {
-            newData->push_back(*it);
+template<typename Predicate>
+void PerfectMatchingSet::retainPackedIf(Predicate shouldRetain) {
+    // Compact ranks and packed matchings together, reading only the latter.
+    size_t numRetained = 0;
+    for (size_t i = 0; i < this->size(); ++i) {
+        if (shouldRetain(this->packed[i])) {
+            this->writable[numRetained] = this->writable[i];
+            this->packed[numRetained] = this->packed[i];
+            ++numRetained;
         }
     }
 
-    delete this->data;
-    this->data = newData;
+    if (this->data && this->writable == this->data->data()) {
+        this->data->resize(numRetained);
+    }
+    this->last = this->first + numRetained;
 }
 
-Pm& PerfectMatchingSet::get(int i) const {
-    return this->data->at(unsigned(i));
+void PerfectMatchingSet::filter(const PerfectMatching& p, int n) {
+    if (this->layout == PACKED_LAYOUT) {
+        PackedPerfectMatching guess = packPerfectMatching(p);
+        this->retainPackedIf([guess, n](PackedPerfectMatching pm) {
+            return numInCommonPacked(guess, pm) == n;
+        });
+        return;
+    }
+    this->retainIf([&p, n](const Pm& pm) {
+        return numInCommon(p, pm) == n;
+    });
+}
+
+void PerfectMatchingSet::filter(const Tb& m, bool isMatch) {
+    if (this->layout == PACKED_LAYOUT) {
+        int shift = 4 * m.index;
+        PackedPerfectMatching digit = PackedPerfectMatching(m.charAtIndex - '0');
+        this->retainPackedIf([shift, digit, isMatch](PackedPerfectMatching pm) {
+            return isMatch == (((pm >> shift) & 0xF) == digit);
+        });
+        return;
+    }
+    this->retainIf([&m, isMatch](const Pm& pm) {
+        return isMatch == (pm[m.index] == m.charAtIndex);
+    });
+}
+
+const Pm& PerfectMatchingSet::get(int i) const {
+    if (this->layout == BITSET_LAYOUT) {
+        iterator it = this->begin();
+        it += i;
+        return *it;
+    }
+    return this->perms[this->first[i]];
 }
 
 void PerfectMatchingSet::populateAll() {
-    Pm p = "0123456789";
-    do {
-        this->add(p);
-    } while (next_permutation(p.begin(), p.end()));
+    const PmRank* allRanks = PerfectMatchingUniverse::get().getRanks();
+    if (this->data) {
+        this->data->clear();
+    }
+    this->layout = RANK_LAYOUT;
+    this->first = allRanks;
+    this->last = allRanks + NUM_PERMS;
+    this->writable = nullptr;
+    this->bitset = nullptr;
+    this->bitsetSize = 0;
+    this->packed = nullptr;
+    this->isShared = true;
 }
 
 void PerfectMatchingSet::populateFromFile(string filename) {
@@ -85,14 +409,28 @@ void PerfectMatchingSet::populateFromFile(string filename) {
     ifstream inputFile(filename);
 
     while (inputFile >> s) {
-        this->add(s);
+        if (isPerfectMatching(s)) {
+            this->add(s);
+        }
     }
 
     inputFile.close();
+    this->adaptLayout();
 }
 
-vector<Pm>::size_type PerfectMatchingSet::size() const {
-    return this->data->size();
+size_t PerfectMatchingSet::size() const {
+    if (this->layout == BITSET_LAYOUT) {
+        return this->bitsetSize;
+    }
+    return size_t(this->last - this->first);
+}
+
+uint64_t PerfectMatchingSet::hash() const {
+    uint64_t hash = 14695981039346656037ULL;
+    for (iterator it = this->begin(), end = this->end(); it != end; ++it) {
+        hash = (hash ^ it.rank()) * 1099511628211ULL;
+    }
+    return hash;
 }
 
 PerfectMatchingSet** PerfectMatchingSet::copyIntoChunks(int numChunks) const {
@@ -102,14 +440,23 @@ PerfectMatchingSet** PerfectMatchingSet::copyIntoChunks(int numChunks) const {
 
     int i = 0;
     for (PerfectMatchingSet::iterator beginChunk = this->begin(), endChunk = this->begin();
-         beginChunk != this->end();
+         i < numChunks;
          beginChunk = endChunk) {
         endChunk += chunkSize;
         if (numChunksWithOneExtra-- > 0) {
-            ++endChunk;
+            endChunk += 1;
         }
 
-        chunks[i++] = new PerfectMatchingSet(beginChunk, endChunk);
+        if (this->isShared) {
+            // The universe outlives every set, so chunks may point into it.
+            PerfectMatchingSet* chunk = new PerfectMatchingSet(nullptr);
+            chunk->first = this->first + (beginChunk - this->begin());
+            chunk->last = this->first + (endChunk - this->begin());
+            chunk->isShared = true;
+            chunks[i++] = chunk;
+        } else {
+            chunks[i++] = new PerfectMatchingSet(beginChunk, endChunk);
+        }
     }
     assert(i == numChunks);
 
@@ -8,27 +8,130 @@
 #ifndef GUARD_PERFECT_MATCHING_SET_H
 #define GUARD_PERFECT_MATCHING_SET_H
 
+#include <cstddef>
+#include <iterator>
 #include <vector>
 #include "PerfectMatching.h"
+#include "ScratchArena.h"
 #include "TruthBooth.h"
 
+#define DENSE_SET_MIN_SIZE (NUM_PERMS / 32) // At least this many: a bitset is smaller than ranks.
+#define PACKED_SET_MAX_SIZE (4096)           // At most this many: also keep packed matchings.
+#define NUM_BITSET_WORDS ((NUM_PERMS + 63) / 64)
+
+/**
+ * A list of permutations, stored as ranks into the PerfectMatchingUniverse.
+ * A set filled with populateAll is a view of the universe and costs nothing
+ * to create; storage is only allocated once the set is filtered or added to.
+ *
+ * Filtering picks the layout for the survivors by their number: a bitset
+ * over all ranks while the set is dense, an array of ranks in the middle
+ * game, and ranks together with packed matchings in the end game, so that
+ * filters there only touch a small contiguous array. Every layout lists
+ * the ranks of a filtered universe in increasing order, so iteration and
+ * hash do not depend on the layout.
+ */
 class PerfectMatchingSet {
 private:
-    std::vector<PerfectMatching>* data;
+    enum Layout {
+        RANK_LAYOUT,                       // Ranks in [first, last).
+        BITSET_LAYOUT,                     // Bit r of bitset is set if rank r is in the set.
+        PACKED_LAYOUT                      // Ranks, and packed[i] is the matching of first[i].
+    };
+
+    const PerfectMatching* perms;          // Universe table, indexed by rank.
+    Layout layout;
+    const PerfectMatchingRank* first;      // First rank in this set.
+    const PerfectMatchingRank* last;       // One past the last rank.
+    PerfectMatchingRank* writable;         // Equals first if we may write there.
+    uint64_t* bitset;                      // NUM_BITSET_WORDS words, in BITSET_LAYOUT.
+    size_t bitsetSize;                     // Number of bits set, in BITSET_LAYOUT.
+    PackedPerfectMatching* packed;         // One per rank, in PACKED_LAYOUT.
+    bool isShared;                         // Ranks point into the universe.
+    std::vector<PerfectMatchingRank>* data;// Heap storage, if any.
+    std::vector<uint64_t>* words;          // Heap storage for bitset or packed, if any.
+    ScratchArena* arena;                   // Scratch storage, if any.
+
+    PerfectMatchingSet(const PerfectMatchingSet&) = delete;
+    PerfectMatchingSet& operator=(const PerfectMatchingSet&) = delete;
+
+    PerfectMatchingRank* allocateRanks(size_t numRanks);
+    uint64_t* allocateWords(size_t numWords);
+    void adaptLayout();
+    void convertToBitset(size_t numRanks);
+    void convertToRanks();
+    void convertToPacked();
+
+    template<typename Predicate>
+    void retainIf(Predicate shouldRetain);
+    template<typename Predicate>
+    void retainPackedIf(Predicate shouldRetain);
 public:
-    typedef std::vector<PerfectMatching>::iterator iterator;
-    typedef std::vector<PerfectMatching>::const_iterator const_iterator;
+    /**
+     * Read-only iterator which dereferences to the PerfectMatching of a rank.
+     * Over a bitset it walks the set bits, so moving n steps and taking the
+     * distance between two iterators take time linear in the bits passed.
+     */
+    class const_iterator {
+    private:
+        const PerfectMatching* perms;
+        const PerfectMatchingRank* pos;    // Into the ranks, unless over a bitset.
+        const uint64_t* bitset;            // Set bits, or nullptr over ranks.
+        PerfectMatchingRank bit;           // Current bit, NUM_PERMS at the end.
+
+        void advanceInBitset();
+    public:
+        typedef std::forward_iterator_tag iterator_category;
+        typedef PerfectMatching value_type;
+        typedef std::ptrdiff_t difference_type;
+        typedef const PerfectMatching* pointer;
+        typedef const PerfectMatching& reference;
+
+        const_iterator() : perms(nullptr), pos(nullptr), bitset(nullptr), bit(0) { }
+        const_iterator(const PerfectMatching* perms, const PerfectMatchingRank* pos) :
+                perms(perms), pos(pos), bitset(nullptr), bit(0) { }
+        const_iterator(const PerfectMatching* perms, const uint64_t* bitset,
+                       PerfectMatchingRank bit);
+
+        reference operator*() const { return this->perms[this->rank()]; }
+        pointer operator->() const { return &this->perms[this->rank()]; }
+        PerfectMatchingRank rank() const { return this->bitset ? this->bit : *this->pos; }
+        bool isOverBitset() const { return this->bitset != nullptr; }
+        const_iterator& operator++() {
+            if (this->bitset) {
+                this->advanceInBitset();
+            } else {
+                ++this->pos;
+            }
+            return *this;
+        }
+        const_iterator operator++(int) { const_iterator old(*this); ++*this; return old; }
+        const_iterator& operator+=(difference_type n);
+        difference_type operator-(const const_iterator& that) const;
+        bool operator==(const const_iterator& that) const {
+            return this->pos == that.pos && this->bit == that.bit;
+        }
+        bool operator!=(const const_iterator& that) const { return !(*this == that); }
+    };
+    typedef const_iterator iterator;
 
     PerfectMatchingSet();
+    explicit PerfectMatchingSet(ScratchArena* arena);
     PerfectMatchingSet(iterator begin, iterator end);
     ~PerfectMatchingSet();
 
     /**
      * Add an element to the container.
-     * @param pm Element to add to this PerfectMatchingSet.
+     * @param pm Element to add to this PerfectMatchingSet. Must satisfy isPerfectMatching.
      */
     void add(const PerfectMatching& pm);
 
+    /**
+     * Add an element to the container, given by its rank.
+     * @param rank Rank of the element to add, in [0, NUM_PERMS).
+     */
+    void addRank(PerfectMatchingRank rank);
+
     /**
      * Get the begin iterator, pointing to the first element of the container.
      * @return Beginning iterator for container.
@@ -37,6 +140,7 @@ public:
 
     /**
      * Check whether this PerfectMatchingSet contains a specific PerfectMatching.
+     * Takes constant time for a dense set, else linear time.
      * @param pm The perfect matching to check for.
      * @return True if pm is contained in this PerfectMatchingSet, false otherwise.
      */
@@ -63,14 +167,16 @@ public:
     void filter(const TruthBooth& tbGuess, bool isMatch);
 
     /**
-     * Get the element at index i, not checking for data bounds.
+     * Get the element at index i, not checking for data bounds. Takes time
+     * linear in i for a dense set, so only use it there for the first few.
      * @param i Index of element to get.
      * @return Element in the i-th position.
      */
-    PerfectMatching& get(int i) const;
+    const PerfectMatching& get(int i) const;
 
     /**
-     * Fill with all permutations of the digits 0 through 9.
+     * Fill with all permutations of the digits 0 through 9, in lexicographic
+     * order. The set becomes a view of the universe, so this takes constant time.
      */
     void populateAll();
 
@@ -78,6 +184,7 @@ public:
      * Fill with all permutations in the file at specified path.
      * @param filename
      * Format: File should contain a single 10-digit number per line, nothing else.
+     * Lines which are not permutations of 0123456789 are skipped.
      */
     void populateFromFile(std::string);
 
@@ -85,10 +192,18 @@ public:
      * Get the number of elements in the permutation set.
      * @return Number of elements in container.
      */
-    std::vector<PerfectMatching>::size_type size() const;
+    size_t size() const;
+
+    /**
+     * Get a 64-bit FNV-1a hash of the ranks in the set, in order. Identifies
+     * a set of remaining answers, e.g., to look up a move for it.
+     * @return Hash of the elements of this set.
+     */
+    uint64_t hash() const;
 
     /**
      * Copy container into array of sets with numChunks evenly sized chunks.
+     * Chunks of a view of the universe are themselves views, so no copy is made.
      * @param numChunks Number of chunks in the returned array.
      * @return Array of pointers to PerfectMatchingSets, each a partition of this set.
      */
@@ -0,0 +1,54 @@
+/**
+ * PerfectMatchingUniverse.cpp
+ * Christopher Chute
+ *
+ * Immutable table of every permutation of DIGITS, built once per process.
+ */
+
+#include <algorithm>
+#include <new>
+#include "PerfectMatchingUniverse.h"
+#include "ScratchArena.h"
+
+#ifdef __linux__
+#include <sys/mman.h>
+#endif
+
+typedef PerfectMatching Pm;
+typedef PerfectMatchingRank PmRank;
+
+PerfectMatchingUniverse::PerfectMatchingUniverse() {
+    size_t permsSize = NUM_PERMS * sizeof(Pm);
+    this->arenaSize = permsSize + NUM_PERMS * sizeof(PmRank);
+    this->arena = allocateLargeBlock(this->arenaSize);
+    if (!this->arena) {
+        throw std::bad_alloc();
+    }
+
+    // Permutations are short enough for the small-string buffer, so they
+    // live inside the arena and are released with it, without destructors.
+    Pm* perms = static_cast<Pm*>(this->arena);
+    PmRank* ranks = reinterpret_cast<PmRank*>(static_cast<char*>(this->arena) + permsSize);
+    Pm p = DIGITS;
+    PmRank rank = 0;
+    do {
+        new (perms + rank) Pm(p);
+        ranks[rank] = rank;
+        ++rank;
+    } while (std::next_permutation(p.begin(), p.end()));
+
+#ifdef __linux__
+    mprotect(this->arena, roundUpToLargeBlockSize(this->arenaSize), PROT_READ);
+#endif
+    this->perms = perms;
+    this->ranks = ranks;
+}
+
+PerfectMatchingUniverse::~PerfectMatchingUniverse() {
+    freeLargeBlock(this->arena, this->arenaSize);
+}
+
+const PerfectMatchingUniverse& PerfectMatchingUniverse::get() {
+    static PerfectMatchingUniverse universe;
+    return universe;
+}
@@ -0,0 +1,59 @@
+/**
+ * PerfectMatchingUniverse.h
+ * Christopher Chute
+ *
+ * Immutable table of every permutation of DIGITS, built once per process.
+ */
+
+#ifndef GUARD_PERFECT_MATCHING_UNIVERSE_H
+#define GUARD_PERFECT_MATCHING_UNIVERSE_H
+
+#include <cstddef>
+#include "PerfectMatching.h"
+
+class PerfectMatchingUniverse {
+private:
+    void* arena;                         // Single block holding both tables.
+    size_t arenaSize;                    // Size of arena in bytes.
+    const PerfectMatching* perms;        // Every permutation, indexed by rank.
+    const PerfectMatchingRank* ranks;    // The ranks 0 through NUM_PERMS - 1.
+
+    PerfectMatchingUniverse();
+    ~PerfectMatchingUniverse();
+    PerfectMatchingUniverse(const PerfectMatchingUniverse&) = delete;
+    PerfectMatchingUniverse& operator=(const PerfectMatchingUniverse&) = delete;
+public:
+    /**
+     * Get the universe, generating it on first use. Safe to call from
+     * multiple threads.
+     * @return The single instance for this process.
+     */
+    static const PerfectMatchingUniverse& get();
+
+    /**
+     * Get the permutation with a given rank.
+     * @param rank Rank of the permutation, in [0, NUM_PERMS).
+     * @return Permutation whose getRank is rank.
+     */
+    const PerfectMatching& at(PerfectMatchingRank rank) const {
+        return this->perms[rank];
+    }
+
+    /**
+     * Get the table of all permutations, indexed by rank.
+     * @return Pointer to the permutation of rank 0.
+     */
+    const PerfectMatching* getPerms() const {
+        return this->perms;
+    }
+
+    /**
+     * Get the sorted list of all ranks, for sets which view the whole universe.
+     * @return Pointer to the first of NUM_PERMS consecutive ranks.
+     */
+    const PerfectMatchingRank* getRanks() const {
+        return this->ranks;
+    }
+};
+
+#endif
@@ -0,0 +1,360 @@
+/**
+ * PoolBuilder.cpp
+ * Christopher Chute
+ *
+ * Search for a small pool of fixed guesses for the Informed Guess stage.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <thread>
+#include "PerfectMatchingUniverse.h"
+#include "PoolBuilder.h"
+#include "ayto.h"
+
+#define WEEK_OF_POOL (3) // First week in which the pool can be used.
+
+using std::cout;
+using std::endl;
+using std::ofstream;
+using std::thread;
+using std::vector;
+
+typedef PackedPerfectMatching PackedPm;
+typedef vector<PackedPm> State; // Remaining answers in one reachable state.
+
+// A state of the game at the start of a week, and the booths used to get there.
+struct Branch {
+    PmSet* possibleAnswers;
+    vector<Tb> tbGuessesAlreadyMade;
+    vector<Pm> pmGuessesAlreadyMade;
+};
+
+// Split branch by every feedback the Truth Booth can give, then if
+// isPerfectMatchingPlayed, by every feedback the Perfect Matching can give.
+static void playWeek(const Branch& branch, bool isPerfectMatchingPlayed, vector<Branch>& next) {
+    TbSet tbGuessesAlreadyMade;
+    for (vector<Tb>::const_iterator it = branch.tbGuessesAlreadyMade.begin();
+         it != branch.tbGuessesAlreadyMade.end();
+         ++it) {
+        tbGuessesAlreadyMade.add(*it);
+    }
+    Tb tbGuess = getNextTruthBoothGuess(branch.possibleAnswers, &tbGuessesAlreadyMade);
+
+    for (int isMatch = 0; isMatch <= 1; ++isMatch) {
+        PmSet* afterTb = new PmSet(branch.possibleAnswers->begin(), branch.possibleAnswers->end());
+        afterTb->filter(tbGuess, isMatch == 1);
+        if (afterTb->size() == 0) {
+            delete afterTb;
+            continue;
+        }
+        if (!isPerfectMatchingPlayed) {
+            Branch b = { afterTb, branch.tbGuessesAlreadyMade, branch.pmGuessesAlreadyMade };
+            b.tbGuessesAlreadyMade.push_back(tbGuess);
+            next.push_back(b);
+            continue;
+        }
+
+        PmSet pmGuessesAlreadyMade;
+        for (vector<Pm>::const_iterator it = branch.pmGuessesAlreadyMade.begin();
+             it != branch.pmGuessesAlreadyMade.end();
+             ++it) {
+            pmGuessesAlreadyMade.add(*it);
+        }
+        Pm pmGuess = getNextPerfectMatchingGuess(afterTb, &pmGuessesAlreadyMade);
+        for (int numCorrect = 0; numCorrect < PERM_LENGTH; ++numCorrect) {
+            PmSet* afterPm = new PmSet(afterTb->begin(), afterTb->end());
+            afterPm->filter(pmGuess, numCorrect);
+            if (afterPm->size() == 0) {
+                delete afterPm;
+                continue;
+            }
+            Branch b = { afterPm, branch.tbGuessesAlreadyMade, branch.pmGuessesAlreadyMade };
+            b.tbGuessesAlreadyMade.push_back(tbGuess);
+            b.pmGuessesAlreadyMade.push_back(pmGuess);
+            next.push_back(b);
+        }
+        delete afterTb;
+    }
+}
+
+// Find every state in which the game first chooses from the pool.
+static vector<State> getStatesUsingPool() {
+    vector<Branch> branches;
+    Branch start = { new PmSet(), vector<Tb>(), vector<Pm>() };
+    start.possibleAnswers->populateAll();
+    branches.push_back(start);
+
+    for (int week = 1; week <= WEEK_OF_POOL; ++week) {
+        vector<Branch> next;
+        for (vector<Branch>::const_iterator it = branches.begin(); it != branches.end(); ++it) {
+            playWeek(*it, week < WEEK_OF_POOL, next);
+            delete it->possibleAnswers;
+        }
+        branches.swap(next);
+    }
+
+    vector<State> states;
+    for (vector<Branch>::const_iterator it = branches.begin(); it != branches.end(); ++it) {
+        if (getMinimaxStage(it->possibleAnswers) == POOL_MINIMAX) {
+            State state;
+            state.reserve(it->possibleAnswers->size());
+            for (PmSet::const_iterator answer = it->possibleAnswers->begin();
+                 answer != it->possibleAnswers->end();
+                 ++answer) {
+                state.push_back(packPerfectMatching(*answer));
+            }
+            states.push_back(state);
+        }
+        delete it->possibleAnswers;
+    }
+    return states;
+}
+
+// Fill rows [firstCandidate, endCandidate) of the candidate-by-state matrix
+// of scores, as the game scores a pool guess.
+static void scoreCandidates(const vector<Pm>* candidates,
+                            size_t firstCandidate,
+                            size_t endCandidate,
+                            const vector<State>* states,
+                            ScoringPolicy scoringPolicy,
+                            vector<long>* scores) {
+    for (size_t c = firstCandidate; c < endCandidate; ++c) {
+        PackedPm guess = packPerfectMatching((*candidates)[c]);
+        for (size_t s = 0; s < states->size(); ++s) {
+            int numRemainingGivenResponse[NUM_RESPONSES] = { 0 };
+            const State& state = (*states)[s];
+            for (State::const_iterator it = state.begin(); it != state.end(); ++it) {
+                ++numRemainingGivenResponse[numInCommonPacked(guess, *it)];
+            }
+            (*scores)[c * states->size() + s] =
+                    scoreHistogram(scoringPolicy, numRemainingGivenResponse);
+        }
+    }
+}
+
+// Expected score of the best pool member in each state, where the game
+// ignores guesses no better than one telling nothing apart. A state is
+// reached with probability |state| / 10!.
+static double getObjective(const vector<size_t>& pool,
+                           const vector<long>& scores,
+                           const vector<State>& states,
+                           ScoringPolicy scoringPolicy) {
+    double objective = 0;
+    for (size_t s = 0; s < states.size(); ++s) {
+        long best = getUnsplitScore(scoringPolicy, long(states[s].size()));
+        for (vector<size_t>::const_iterator it = pool.begin(); it != pool.end(); ++it) {
+            best = std::min(best, scores[*it * states.size() + s]);
+        }
+        objective += double(states[s].size()) * double(best) / NUM_PERMS;
+    }
+    return objective;
+}
+
+// Objective of the pool with one member swapped for candidate c, given the
+// best score in each state of the members that stay.
+static double getSwappedObjective(size_t c,
+                                  const vector<long>& bestWithout,
+                                  const vector<long>& scores,
+                                  const vector<State>& states) {
+    double swapped = 0;
+    for (size_t s = 0; s < states.size(); ++s) {
+        swapped += double(states[s].size()) *
+                   double(std::min(bestWithout[s], scores[c * states.size() + s])) /
+                   NUM_PERMS;
+    }
+    return swapped;
+}
+
+// Scan candidates [firstCandidate, endCandidate) for the first swap that
+// lowers the objective, and lower firstImproving to it. Stops early once a
+// thread scanning earlier candidates has found one, so the swap taken is
+// the one a single thread scanning in order would take.
+static void findImprovingSwap(const vector<bool>* isInPool,
+                              size_t firstCandidate,
+                              size_t endCandidate,
+                              const vector<long>* bestWithout,
+                              const vector<long>* scores,
+                              const vector<State>* states,
+                              double objective,
+                              std::atomic<size_t>* firstImproving) {
+    for (size_t c = firstCandidate; c < endCandidate && c < firstImproving->load(); ++c) {
+        if ((*isInPool)[c]) {
+            continue;
+        }
+        if (getSwappedObjective(c, *bestWithout, *scores, *states) < objective - 1e-9) {
+            size_t current = firstImproving->load();
+            while (c < current && !firstImproving->compare_exchange_weak(current, c)) {
+            }
+            return;
+        }
+    }
+}
+
+bool buildGuessPool(const PoolBuilderSettings& settings) {
+    cout << "Finding week " << WEEK_OF_POOL << " states which use the pool." << endl;
+    vector<State> states = getStatesUsingPool();
+    size_t numStates = states.size();
+    long numAnswers = 0;
+    for (vector<State>::const_iterator it = states.begin(); it != states.end(); ++it) {
+        numAnswers += long(it->size());
+    }
+    cout << "    " << numStates << " states, " << numAnswers << " answers." << endl;
+
+    // Candidates: the existing pool, if any, then distinct random permutations.
+    vector<Pm> candidates;
+    PmSet seedPool;
+    if (!settings._seedPoolFile.empty()) {
+        seedPool.populateFromFile(settings._seedPoolFile);
+    }
+    for (PmSet::const_iterator it = seedPool.begin(); it != seedPool.end(); ++it) {
+        candidates.push_back(*it);
+    }
+    size_t numSeedCandidates = candidates.size();
+    std::mt19937 rng(settings._seed);
+    std::uniform_int_distribution<PmRank> randomRank(0, NUM_PERMS - 1);
+    vector<bool> isCandidate(NUM_PERMS, false);
+    for (vector<Pm>::const_iterator it = candidates.begin(); it != candidates.end(); ++it) {
+        isCandidate[getRank(*it)] = true;
+    }
+    while (candidates.size() < numSeedCandidates + size_t(settings._numCandidates)) {
+        PmRank rank = randomRank(rng);
+        if (!isCandidate[rank]) {
+            isCandidate[rank] = true;
+            candidates.push_back(PerfectMatchingUniverse::get().at(rank));
+        }
+    }
+
+    cout << "Scoring " << candidates.size() << " candidates on "
+         << settings._numThreads << " threads." << endl;
+    vector<long> scores(candidates.size() * numStates);
+    vector<thread> scoringThreads;
+    for (int id = 0; id < settings._numThreads; ++id) {
+        scoringThreads.push_back(thread(scoreCandidates,
+                                        &candidates,
+                                        candidates.size() * id / settings._numThreads,
+                                        candidates.size() * (id + 1) / settings._numThreads,
+                                        &states,
+                                        settings._scoringPolicy,
+                                        &scores));
+    }
+    for (vector<thread>::iterator it = scoringThreads.begin(); it != scoringThreads.end(); ++it) {
+        it->join();
+    }
+
+    // Greedy: repeatedly add the candidate that lowers the objective most.
+    size_t poolSize = std::min(size_t(settings._poolSize), candidates.size());
+    vector<size_t> pool;
+    vector<bool> isInPool(candidates.size(), false);
+    vector<long> bestInPool(numStates);
+    for (size_t s = 0; s < numStates; ++s) {
+        bestInPool[s] = getUnsplitScore(settings._scoringPolicy, long(states[s].size()));
+    }
+    while (pool.size() < poolSize) {
+        size_t bestCandidate = 0;
+        double bestGain = -1;
+        for (size_t c = 0; c < candidates.size(); ++c) {
+            if (isInPool[c]) {
+                continue;
+            }
+            double gain = 0;
+            for (size_t s = 0; s < numStates; ++s) {
+                long score = scores[c * numStates + s];
+                if (score < bestInPool[s]) {
+                    gain += double(states[s].size()) * double(bestInPool[s] - score);
+                }
+            }
+            if (gain > bestGain) {
+                bestCandidate = c;
+                bestGain = gain;
+            }
+        }
+        pool.push_back(bestCandidate);
+        isInPool[bestCandidate] = true;
+        for (size_t s = 0; s < numStates; ++s) {
+            bestInPool[s] = std::min(bestInPool[s], scores[bestCandidate * numStates + s]);
+        }
+    }
+    // Under minimax the score is the number of answers left.
+    const char* scoreName = settings._scoringPolicy == MINIMAX_SCORE
+            ? " answers left on average."
+            : " average score.";
+    double objective = getObjective(pool, scores, states, settings._scoringPolicy);
+    cout << "    Greedy pool: " << objective << scoreName << endl;
+
+    // Local search: swap a pool member for an outside candidate while it
+    // helps, taking the first such candidate. The candidates are split
+    // between the threads, as for scoring.
+    bool isImproved = true;
+    while (isImproved) {
+        isImproved = false;
+        for (size_t p = 0; p < pool.size(); ++p) {
+            // Best score in each state without pool member p.
+            vector<long> bestWithout(numStates);
+            for (size_t s = 0; s < numStates; ++s) {
+                bestWithout[s] = getUnsplitScore(settings._scoringPolicy,
+                                                 long(states[s].size()));
+                for (size_t q = 0; q < pool.size(); ++q) {
+                    if (q != p) {
+                        bestWithout[s] = std::min(bestWithout[s], scores[pool[q] * numStates + s]);
+                    }
+                }
+            }
+            std::atomic<size_t> firstImproving(candidates.size());
+            vector<thread> swapThreads;
+            for (int id = 0; id < settings._numThreads; ++id) {
+                swapThreads.push_back(thread(findImprovingSwap,
+                                             &isInPool,
+                                             candidates.size() * id / settings._numThreads,
+                                             candidates.size() * (id + 1) / settings._numThreads,
+                                             &bestWithout,
+                                             &scores,
+                                             &states,
+                                             objective,
+                                             &firstImproving));
+            }
+            for (vector<thread>::iterator it = swapThreads.begin(); it != swapThreads.end(); ++it) {
+                it->join();
+            }
+            size_t c = firstImproving.load();
+            if (c < candidates.size()) {
+                isInPool[pool[p]] = false;
+                isInPool[c] = true;
+                pool[p] = c;
+                objective = getSwappedObjective(c, bestWithout, scores, states);
+                isImproved = true;
+            }
+        }
+    }
+    cout << "    After swaps: " << objective << scoreName << endl;
+
+    vector<size_t> allCandidates(candidates.size());
+    for (size_t c = 0; c < candidates.size(); ++c) {
+        allCandidates[c] = c;
+    }
+    cout << "    All " << candidates.size() << " candidates: "
+         << getObjective(allCandidates, scores, states, settings._scoringPolicy)
+         << scoreName << endl;
+    if (numSeedCandidates > 0) {
+        vector<size_t> seedPoolIndices(allCandidates.begin(),
+                                       allCandidates.begin() + numSeedCandidates);
+        cout << "    Existing pool of " << numSeedCandidates << ": "
+             << getObjective(seedPoolIndices, scores, states, settings._scoringPolicy)
+             << scoreName << endl;
+    }
+
+    ofstream outputFile(settings._outputFile);
+    for (vector<size_t>::const_iterator it = pool.begin(); it != pool.end(); ++it) {
+        outputFile << candidates[*it] << "\n";
+    }
+    outputFile.close();
+    if (!outputFile) {
+        cout << "Could not write " << settings._outputFile << "." << endl;
+        return false;
+    }
+    cout << "Wrote " << pool.size() << " guesses to " << settings._outputFile << "." << endl;
+    return true;
+}
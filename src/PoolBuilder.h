@@ -0,0 +1,50 @@
+/**
+ * PoolBuilder.h
+ * Christopher Chute
+ *
+ * Search for a small pool of fixed guesses for the Informed Guess stage.
+ * The pool is judged on the states the game can actually be in when it
+ * first needs the pool: after the fixed guesses of weeks 1 and 2 and the
+ * Truth Booth of week 3.
+ */
+
+#ifndef GUARD_POOL_BUILDER_H
+#define GUARD_POOL_BUILDER_H
+
+#include <string>
+#include "ScoringPolicy.h"
+
+/**
+ * Settings for building a pool of guesses.
+ */
+struct PoolBuilderSettings {
+    std::string _outputFile;    // Where to write the pool, one guess per line.
+    std::string _seedPoolFile;  // Existing pool whose guesses are also candidates.
+    int _poolSize;              // Number of guesses in the pool.
+    int _numCandidates;         // Random permutations to choose the pool from.
+    int _numThreads;            // Threads used to score candidates.
+    unsigned int _seed;         // Seed for drawing random candidates.
+    ScoringPolicy _scoringPolicy; // How the game scores pool guesses.
+    PoolBuilderSettings() :
+            _outputFile(""),
+            _seedPoolFile(""),
+            _poolSize(200),
+            _numCandidates(2000),
+            _numThreads(1),
+            _seed(1),
+            _scoringPolicy(MINIMAX_SCORE)
+    {}
+};
+
+/**
+ * Build a pool of guesses and write it to settings._outputFile. Candidates
+ * are scored by settings._scoringPolicy, by default their worst-case split,
+ * in every week-3 state that uses the pool; the pool is chosen greedily,
+ * then improved by swapping guesses, to minimize the expected score of the
+ * best pool guess.
+ * @param settings What to build and how hard to search.
+ * @return True if the pool was written, false otherwise.
+ */
+bool buildGuessPool(const PoolBuilderSettings& settings);
+
+#endif
@@ -0,0 +1,161 @@
+/**
+ * ResultWriter.cpp
+ * Christopher Chute
+ *
+ * Record of a single game, and a buffered writer for one record per game.
+ */
+
+#include <cctype>
+#include <cstdint>
+#include <unistd.h>
+#include "ResultWriter.h"
+
+using std::lock_guard;
+using std::mutex;
+using std::string;
+using std::vector;
+
+ResultWriter::ResultWriter(FILE* f, bool b, bool o) :
+        file(f),
+        ownsFile(o),
+        isBinary(b),
+        buffer(new vector<char>()),
+        writeLock(new mutex())
+{
+    this->buffer->reserve(RESULT_BUFFER_SIZE);
+}
+
+ResultWriter::~ResultWriter() {
+    this->flush();
+    if (this->ownsFile) {
+        fclose(this->file);
+    }
+    delete this->buffer;
+    delete this->writeLock;
+}
+
+void ResultWriter::append(const char* bytes, size_t numBytes) {
+    if (this->buffer->size() + numBytes > RESULT_BUFFER_SIZE) {
+        this->flushBuffer();
+    }
+    this->buffer->insert(this->buffer->end(), bytes, bytes + numBytes);
+}
+
+void ResultWriter::flushBuffer() {
+    if (!this->buffer->empty()) {
+        fwrite(this->buffer->data(), 1, this->buffer->size(), this->file);
+        this->buffer->clear();
+    }
+    fflush(this->file);
+}
+
+void ResultWriter::write(const GameRecord& record) {
+    // Format the record outside the lock, then copy it in.
+    string bytes;
+    bytes.reserve(2 * PERM_LENGTH + record._weeks.size() * (PERM_LENGTH + 4));
+
+    if (this->isBinary) {
+        uint32_t answerRank = getRank(record._answer);
+        bytes.append(reinterpret_cast<const char*>(&answerRank), sizeof(answerRank));
+        bytes += char(record._weeks.size());
+        for (vector<WeekRecord>::const_iterator it = record._weeks.begin();
+             it != record._weeks.end();
+             ++it) {
+            uint32_t pmRank = getRank(it->_perfectMatching);
+            bytes += char(10 * it->_truthBooth.index + (it->_truthBooth.charAtIndex - '0'));
+            bytes.append(reinterpret_cast<const char*>(&pmRank), sizeof(pmRank));
+        }
+    } else {
+        bytes += record._answer;
+        bytes += ' ';
+        bytes += std::to_string(record._weeks.size());
+        for (vector<WeekRecord>::const_iterator it = record._weeks.begin();
+             it != record._weeks.end();
+             ++it) {
+            bytes += ' ';
+            bytes += it->_truthBooth.toString();
+            bytes += ':';
+            bytes += it->_perfectMatching;
+        }
+        bytes += '\n';
+    }
+
+    lock_guard<mutex> guard(*this->writeLock);
+    this->append(bytes.data(), bytes.size());
+}
+
+void ResultWriter::writeText(const string& text) {
+    lock_guard<mutex> guard(*this->writeLock);
+    this->append(text.data(), text.size());
+}
+
+void ResultWriter::flush() {
+    lock_guard<mutex> guard(*this->writeLock);
+    this->flushBuffer();
+}
+
+// Whether a text line, read up to PERM_LENGTH + 1 characters, starts a record.
+static bool isRecordLine(const string& head) {
+    if (head.size() != PERM_LENGTH + 1 || head[PERM_LENGTH] != ' ') {
+        return false;
+    }
+    for (int i = 0; i < PERM_LENGTH; ++i) {
+        if (!isdigit(static_cast<unsigned char>(head[i]))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool ResultWriter::truncateToRecords(size_t numRecords) {
+    lock_guard<mutex> guard(*this->writeLock);
+    this->flushBuffer();
+    fseek(this->file, 0, SEEK_END);
+    long fileSize = ftell(this->file);
+    rewind(this->file);
+
+    // Offset just past the last byte kept, and whole records before it.
+    long keepEnd = 0;
+    size_t numKept = 0;
+    if (this->isBinary) {
+        const long headerSize = sizeof(uint32_t) + 1;
+        const long weekSize = 1 + sizeof(uint32_t);
+        while (numKept < numRecords && keepEnd + headerSize <= fileSize) {
+            fseek(this->file, keepEnd + sizeof(uint32_t), SEEK_SET);
+            int numWeeks = getc(this->file);
+            long recordEnd = keepEnd + headerSize + weekSize * numWeeks;
+            if (numWeeks == EOF || recordEnd > fileSize) {
+                break;
+            }
+            keepEnd = recordEnd;
+            ++numKept;
+        }
+    } else {
+        // Keep whole lines up to the first record past numRecords.
+        string head;
+        long offset = 0;
+        int c;
+        while ((c = getc(this->file)) != EOF) {
+            ++offset;
+            if (c != '\n') {
+                if (head.size() <= PERM_LENGTH) {
+                    head += char(c);
+                }
+                continue;
+            }
+            if (isRecordLine(head)) {
+                if (numKept == numRecords) {
+                    break;
+                }
+                ++numKept;
+            }
+            keepEnd = offset;
+            head.clear();
+        }
+    }
+
+    fflush(this->file);
+    bool isCut = ftruncate(fileno(this->file), keepEnd) == 0;
+    fseek(this->file, 0, SEEK_END);
+    return isCut && numKept == numRecords;
+}
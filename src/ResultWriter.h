@@ -0,0 +1,102 @@
+/**
+ * ResultWriter.h
+ * Christopher Chute
+ *
+ * Record of a single game, and a buffered writer for one record per game.
+ */
+
+#ifndef GUARD_RESULT_WRITER_H
+#define GUARD_RESULT_WRITER_H
+
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "PerfectMatching.h"
+#include "TruthBooth.h"
+
+#define RESULT_BUFFER_SIZE ((size_t) 1 << 20) // Bytes buffered before a write.
+
+/**
+ * Guesses and feedback of one week of a game.
+ */
+struct WeekRecord {
+    TruthBooth _truthBooth;           // Pair sent to the Truth Booth.
+    bool _isMatch;                    // Feedback on _truthBooth.
+    size_t _numRemainingAfterTb;      // Possible answers after that feedback.
+    PerfectMatching _perfectMatching; // Guess at the Perfect Matching ceremony.
+    int _numCorrect;                  // Feedback on _perfectMatching.
+    size_t _numRemainingAfterPm;      // Possible answers after that feedback.
+};
+
+/**
+ * Everything that happened in one game, enough to print its transcript.
+ */
+struct GameRecord {
+    PerfectMatching _answer;          // Hidden answer, empty in interactive mode.
+    std::vector<WeekRecord> _weeks;   // One entry per week played.
+};
+
+/**
+ * Writes one compact record per game through a large buffer. Text records
+ * are a line "<answer> <weeks> <tb>:<pm> ...", where each Truth Booth is
+ * written as its index and character. Binary records are the answer's rank
+ * (uint32), the number of weeks (uint8), then per week the Truth Booth as
+ * 10 * index + digit (uint8) and the Perfect Matching's rank (uint32), all
+ * in host byte order. Safe to share between threads.
+ */
+class ResultWriter {
+private:
+    FILE* file;                  // Destination of the records.
+    bool ownsFile;               // Whether to close file when done.
+    bool isBinary;               // Binary rather than text records.
+    std::vector<char>* buffer;   // Records not yet written to file.
+    std::mutex* writeLock;       // Guards buffer.
+
+    void append(const char* bytes, size_t numBytes);
+    void flushBuffer();
+public:
+    /**
+     * Create a writer for an already open file.
+     * @param file File to write records to, e.g., stdout.
+     * @param isBinary Whether to write binary rather than text records.
+     * @param ownsFile Whether the writer should close file when destroyed.
+     */
+    ResultWriter(FILE* file, bool isBinary, bool ownsFile);
+    ~ResultWriter();
+
+    /**
+     * Check whether records are binary.
+     * @return True if records are binary, false if they are text.
+     */
+    bool isBinaryFormat() const { return this->isBinary; }
+
+    /**
+     * Append the record of a finished game.
+     * @param record Game to write.
+     */
+    void write(const GameRecord& record);
+
+    /**
+     * Append free-form text, e.g., a full transcript. Only for text records.
+     * @param text Text to write, including any line breaks.
+     */
+    void writeText(const std::string& text);
+
+    /**
+     * Write out everything buffered so far.
+     */
+    void flush();
+
+    /**
+     * Cut the file back to its first numRecords records, e.g., the games a
+     * checkpoint holds, dropping records written after them and any partial
+     * record at the end. Text between records, such as transcripts, stays.
+     * The file must be open for reading and appending.
+     * @param numRecords Records to keep.
+     * @return True if the file held at least numRecords whole records.
+     */
+    bool truncateToRecords(size_t numRecords);
+};
+
+#endif
@@ -0,0 +1,207 @@
+/**
+ * RunResults.cpp
+ * Christopher Chute
+ *
+ * Statistics for a run over a range of answers, saved to and merged from
+ * plain text files so that a long run can be split, stopped and resumed.
+ */
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include "RunResults.h"
+
+#define RESULTS_FORMAT ("ayto-results-1") // First line of every results file.
+
+using std::endl;
+using std::ifstream;
+using std::istringstream;
+using std::ofstream;
+using std::ostream;
+using std::string;
+using std::vector;
+
+typedef PerfectMatching Pm;
+typedef PerfectMatchingRank PmRank;
+
+RunResults::RunResults(int i, int n) :
+        shardIndex(i),
+        numShards(n),
+        firstRank(PmRank((long long) NUM_PERMS * i / n)),
+        endRank(PmRank((long long) NUM_PERMS * (i + 1) / n)),
+        weeksHistogram(new vector<long>()),
+        worstAnswers(new vector<Pm>())
+{
+    this->nextRank = this->firstRank;
+}
+
+RunResults::RunResults(const RunResults& that) :
+        shardIndex(that.shardIndex),
+        numShards(that.numShards),
+        firstRank(that.firstRank),
+        endRank(that.endRank),
+        nextRank(that.nextRank),
+        weeksHistogram(new vector<long>(*that.weeksHistogram)),
+        worstAnswers(new vector<Pm>(*that.worstAnswers))
+{}
+
+RunResults& RunResults::operator=(const RunResults& that) {
+    if (this != &that) {
+        this->shardIndex = that.shardIndex;
+        this->numShards = that.numShards;
+        this->firstRank = that.firstRank;
+        this->endRank = that.endRank;
+        this->nextRank = that.nextRank;
+        *this->weeksHistogram = *that.weeksHistogram;
+        *this->worstAnswers = *that.worstAnswers;
+    }
+    return *this;
+}
+
+RunResults::~RunResults() {
+    delete this->weeksHistogram;
+    delete this->worstAnswers;
+}
+
+void RunResults::record(const Pm& answer, int numWeeks) {
+    int worstWeeks = int(this->weeksHistogram->size()) - 1;
+    if (numWeeks > worstWeeks) {
+        this->weeksHistogram->resize(numWeeks + 1, 0);
+        this->worstAnswers->clear();
+    }
+    ++(*this->weeksHistogram)[numWeeks];
+    if (numWeeks >= worstWeeks && this->worstAnswers->size() < MAX_WORST_ANSWERS) {
+        this->worstAnswers->push_back(answer);
+    }
+    ++this->nextRank;
+}
+
+void RunResults::merge(const RunResults& that) {
+    size_t worstWeeks = this->weeksHistogram->size();
+    size_t thatWorstWeeks = that.weeksHistogram->size();
+    if (thatWorstWeeks > worstWeeks) {
+        this->weeksHistogram->resize(thatWorstWeeks, 0);
+        *this->worstAnswers = *that.worstAnswers;
+    } else if (thatWorstWeeks == worstWeeks) {
+        for (vector<Pm>::const_iterator it = that.worstAnswers->begin();
+             it != that.worstAnswers->end() &&
+             this->worstAnswers->size() < MAX_WORST_ANSWERS;
+             ++it) {
+            this->worstAnswers->push_back(*it);
+        }
+    }
+    for (size_t w = 0; w < thatWorstWeeks; ++w) {
+        (*this->weeksHistogram)[w] += (*that.weeksHistogram)[w];
+    }
+}
+
+void RunResults::setRanks(PmRank first, PmRank next, PmRank end) {
+    this->firstRank = first;
+    this->nextRank = next;
+    this->endRank = end;
+}
+
+long RunResults::getNumGames() const {
+    long numGames = 0;
+    for (vector<long>::const_iterator it = this->weeksHistogram->begin();
+         it != this->weeksHistogram->end();
+         ++it) {
+        numGames += *it;
+    }
+    return numGames;
+}
+
+bool RunResults::saveToFile(const string& filename) const {
+    string tmpFilename = filename + ".tmp";
+    ofstream outputFile(tmpFilename);
+    if (!outputFile) {
+        return false;
+    }
+
+    outputFile << RESULTS_FORMAT << "\n"
+               << "shard " << this->shardIndex << " " << this->numShards << "\n"
+               << "range " << this->firstRank << " " << this->endRank << "\n"
+               << "next " << this->nextRank << "\n";
+    for (size_t w = 0; w < this->weeksHistogram->size(); ++w) {
+        if ((*this->weeksHistogram)[w] > 0) {
+            outputFile << "weeks " << w << " " << (*this->weeksHistogram)[w] << "\n";
+        }
+    }
+    for (vector<Pm>::const_iterator it = this->worstAnswers->begin();
+         it != this->worstAnswers->end();
+         ++it) {
+        outputFile << "worst " << *it << "\n";
+    }
+    outputFile.close();
+    if (!outputFile) {
+        return false;
+    }
+
+    return std::rename(tmpFilename.c_str(), filename.c_str()) == 0;
+}
+
+bool RunResults::loadFromFile(const string& filename) {
+    ifstream inputFile(filename);
+    string line;
+    if (!getline(inputFile, line) || line != RESULTS_FORMAT) {
+        return false;
+    }
+
+    vector<long> histogram;
+    vector<Pm> worst;
+    while (getline(inputFile, line)) {
+        istringstream fields(line);
+        string key;
+        if (!(fields >> key)) {
+            continue;
+        }
+        if (key == "shard") {
+            fields >> this->shardIndex >> this->numShards;
+        } else if (key == "range") {
+            fields >> this->firstRank >> this->endRank;
+        } else if (key == "next") {
+            fields >> this->nextRank;
+        } else if (key == "weeks") {
+            size_t w;
+            long count;
+            fields >> w >> count;
+            if (fields && w >= histogram.size()) {
+                histogram.resize(w + 1, 0);
+            }
+            if (fields) {
+                histogram[w] = count;
+            }
+        } else if (key == "worst") {
+            Pm answer;
+            fields >> answer;
+            if (isPerfectMatching(answer)) {
+                worst.push_back(answer);
+            }
+        }
+        if (!fields) {
+            return false;
+        }
+    }
+
+    *this->weeksHistogram = histogram;
+    *this->worstAnswers = worst;
+    return this->firstRank <= this->nextRank && this->nextRank <= this->endRank;
+}
+
+void RunResults::printSummary(ostream& out) const {
+    out << "Played " << this->getNumGames() << " games." << endl;
+    for (size_t w = 0; w < this->weeksHistogram->size(); ++w) {
+        if ((*this->weeksHistogram)[w] > 0) {
+            out << "[Week " << w << "] " << (*this->weeksHistogram)[w] << " games" << endl;
+        }
+    }
+    if (!this->worstAnswers->empty()) {
+        out << "Answers taking " << (this->weeksHistogram->size() - 1) << " weeks:" << endl;
+        for (vector<Pm>::const_iterator it = this->worstAnswers->begin();
+             it != this->worstAnswers->end();
+             ++it) {
+            out << "    " << *it << endl;
+        }
+    }
+}
@@ -0,0 +1,102 @@
+/**
+ * RunResults.h
+ * Christopher Chute
+ *
+ * Statistics for a run over a range of answers, saved to and merged from
+ * plain text files so that a long run can be split, stopped and resumed.
+ */
+
+#ifndef GUARD_RUN_RESULTS_H
+#define GUARD_RUN_RESULTS_H
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include "PerfectMatching.h"
+
+#define MAX_WORST_ANSWERS (100) // Worst-case answers kept per results file.
+
+class RunResults {
+private:
+    int shardIndex;                         // Which shard these results cover.
+    int numShards;                          // Total number of shards in the run.
+    PerfectMatchingRank firstRank;          // First answer rank in the shard.
+    PerfectMatchingRank endRank;            // One past the last answer rank.
+    PerfectMatchingRank nextRank;           // First answer rank not yet played.
+    std::vector<long>* weeksHistogram;      // Index w counts games won in week w.
+    std::vector<PerfectMatching>* worstAnswers; // Answers needing the most weeks.
+public:
+    /**
+     * Create empty results for shard shardIndex of numShards. Shards split
+     * the answer ranks [0, NUM_PERMS) into numShards contiguous ranges.
+     * @param shardIndex Index of this shard, in [0, numShards).
+     * @param numShards Number of shards the run is split into.
+     */
+    RunResults(int shardIndex, int numShards);
+    RunResults(const RunResults& that);
+    RunResults& operator=(const RunResults& that);
+    ~RunResults();
+
+    /**
+     * Record the outcome of the game for the answer of rank nextRank,
+     * and advance nextRank.
+     * @param answer Answer of the game that was played.
+     * @param numWeeks Number of weeks it took to find the answer.
+     */
+    void record(const PerfectMatching& answer, int numWeeks);
+
+    /**
+     * Combine the statistics of another file's results into these.
+     * @param that Results to merge in.
+     */
+    void merge(const RunResults& that);
+
+    /**
+     * Set which answer ranks these results cover, e.g., after a merge.
+     * @param first First answer rank covered.
+     * @param next First answer rank not yet played; all before it were.
+     * @param end One past the last answer rank covered.
+     */
+    void setRanks(PerfectMatchingRank first, PerfectMatchingRank next, PerfectMatchingRank end);
+
+    /**
+     * Check whether every answer in the shard has been played.
+     * @return True if nextRank has reached endRank.
+     */
+    bool isComplete() const { return this->nextRank == this->endRank; }
+
+    PerfectMatchingRank getFirstRank() const { return this->firstRank; }
+    PerfectMatchingRank getEndRank() const { return this->endRank; }
+    PerfectMatchingRank getNextRank() const { return this->nextRank; }
+    int getShardIndex() const { return this->shardIndex; }
+    int getNumShards() const { return this->numShards; }
+
+    /**
+     * Get the total number of games recorded.
+     * @return Sum of the weeks histogram.
+     */
+    long getNumGames() const;
+
+    /**
+     * Write these results to a file. The file is replaced atomically, so a
+     * crash while saving leaves the previous checkpoint intact.
+     * @param filename Path of the file to write.
+     * @return True on success, false if the file could not be written.
+     */
+    bool saveToFile(const std::string& filename) const;
+
+    /**
+     * Read results written by saveToFile.
+     * @param filename Path of the file to read.
+     * @return True on success, false if the file is missing or malformed.
+     */
+    bool loadFromFile(const std::string& filename);
+
+    /**
+     * Print the weeks histogram and worst-case answers.
+     * @param out Stream to print to.
+     */
+    void printSummary(std::ostream& out) const;
+};
+
+#endif
@@ -0,0 +1,135 @@
+/**
+ * SampleStatistics.cpp
+ * Christopher Chute
+ *
+ * Statistics for games played on randomly sampled answers.
+ */
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <iomanip>
+#include "SampleStatistics.h"
+
+#define Z_95 (1.959964) // Standard normal quantile for 95% confidence.
+
+using std::endl;
+using std::ostream;
+using std::vector;
+
+// Wilson score interval for a proportion of numHits in numTrials.
+static void getWilsonInterval(long numHits, long numTrials, double* low, double* high) {
+    double n = double(numTrials);
+    double p = double(numHits) / n;
+    double z2 = Z_95 * Z_95;
+    double center = (p + z2 / (2 * n)) / (1 + z2 / n);
+    double halfWidth = Z_95 * std::sqrt(p * (1 - p) / n + z2 / (4 * n * n)) / (1 + z2 / n);
+    *low = std::max(0.0, center - halfWidth);
+    *high = std::min(1.0, center + halfWidth);
+}
+
+// Half width of the normal 95% interval for a mean, from running sums.
+static double getHalfWidth(double sum, double sumOfSquares, long count) {
+    if (count < 2) {
+        return DBL_MAX;
+    }
+    double mean = sum / count;
+    double variance = std::max(0.0, (sumOfSquares - count * mean * mean) / (count - 1));
+    return Z_95 * std::sqrt(variance / count);
+}
+
+SampleStatistics::SampleStatistics() :
+        weeksHistogram(new vector<long>()),
+        numGames(0),
+        sumWeeks(0),
+        sumSquaredWeeks(0),
+        sumSecondsPerWeek(0),
+        sumSquaredSecondsPerWeek(0)
+{}
+
+SampleStatistics::SampleStatistics(const SampleStatistics& that) :
+        weeksHistogram(new vector<long>(*that.weeksHistogram)),
+        numGames(that.numGames),
+        sumWeeks(that.sumWeeks),
+        sumSquaredWeeks(that.sumSquaredWeeks),
+        sumSecondsPerWeek(that.sumSecondsPerWeek),
+        sumSquaredSecondsPerWeek(that.sumSquaredSecondsPerWeek)
+{}
+
+SampleStatistics& SampleStatistics::operator=(const SampleStatistics& that) {
+    if (this != &that) {
+        *this->weeksHistogram = *that.weeksHistogram;
+        this->numGames = that.numGames;
+        this->sumWeeks = that.sumWeeks;
+        this->sumSquaredWeeks = that.sumSquaredWeeks;
+        this->sumSecondsPerWeek = that.sumSecondsPerWeek;
+        this->sumSquaredSecondsPerWeek = that.sumSquaredSecondsPerWeek;
+    }
+    return *this;
+}
+
+SampleStatistics::~SampleStatistics() {
+    delete this->weeksHistogram;
+}
+
+void SampleStatistics::record(int numWeeks, double secondsPerWeek) {
+    if (this->weeksHistogram->size() <= size_t(numWeeks)) {
+        this->weeksHistogram->resize(size_t(numWeeks) + 1, 0);
+    }
+    ++(*this->weeksHistogram)[size_t(numWeeks)];
+    ++this->numGames;
+    this->sumWeeks += numWeeks;
+    this->sumSquaredWeeks += double(numWeeks) * numWeeks;
+    this->sumSecondsPerWeek += secondsPerWeek;
+    this->sumSquaredSecondsPerWeek += secondsPerWeek * secondsPerWeek;
+}
+
+double SampleStatistics::getMeanWeeks() const {
+    return this->numGames > 0 ? this->sumWeeks / this->numGames : 0;
+}
+
+double SampleStatistics::getMeanWeeksHalfWidth() const {
+    return getHalfWidth(this->sumWeeks, this->sumSquaredWeeks, this->numGames);
+}
+
+void SampleStatistics::printSummary(ostream& out) const {
+    out << "Played " << this->numGames << " sampled games." << endl;
+    if (this->numGames == 0) {
+        return;
+    }
+    std::ios::fmtflags flags = out.flags();
+    std::streamsize precision = out.precision();
+    out << std::fixed << std::setprecision(4);
+
+    double low;
+    double high;
+    long numLost = 0;
+    for (size_t w = 0; w < this->weeksHistogram->size(); ++w) {
+        long count = (*this->weeksHistogram)[w];
+        if (w > MAX_WEEKS_TO_WIN) {
+            numLost += count;
+        }
+        if (count > 0) {
+            getWilsonInterval(count, this->numGames, &low, &high);
+            out << "[Week " << w << "] " << count << " games, "
+                << double(count) / this->numGames
+                << " [" << low << ", " << high << "]" << endl;
+        }
+    }
+
+    out << "Mean weeks: " << this->getMeanWeeks() << " +/- "
+        << this->getMeanWeeksHalfWidth() << endl;
+    getWilsonInterval(numLost, this->numGames, &low, &high);
+    out << "More than " << MAX_WEEKS_TO_WIN << " weeks: "
+        << double(numLost) / this->numGames << " [" << low << ", " << high << "]" << endl;
+    out << "Seconds per week: " << this->sumSecondsPerWeek / this->numGames;
+    if (this->numGames > 1) {
+        out << " +/- " << getHalfWidth(this->sumSecondsPerWeek,
+                                       this->sumSquaredSecondsPerWeek,
+                                       this->numGames);
+    }
+    out << endl;
+
+    out.flags(flags);
+    out.precision(precision);
+}
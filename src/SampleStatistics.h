@@ -0,0 +1,63 @@
+/**
+ * SampleStatistics.h
+ * Christopher Chute
+ *
+ * Statistics for games played on randomly sampled answers, with 95%
+ * confidence intervals for what a run over every answer would find.
+ */
+
+#ifndef GUARD_SAMPLE_STATISTICS_H
+#define GUARD_SAMPLE_STATISTICS_H
+
+#include <iostream>
+#include <vector>
+
+#define MAX_WEEKS_TO_WIN (10) // Games taking more weeks than this are lost.
+
+class SampleStatistics {
+private:
+    std::vector<long>* weeksHistogram; // Index w counts games won in week w.
+    long numGames;
+    double sumWeeks;
+    double sumSquaredWeeks;
+    double sumSecondsPerWeek;          // Mean week of each game, summed.
+    double sumSquaredSecondsPerWeek;
+public:
+    SampleStatistics();
+    SampleStatistics(const SampleStatistics& that);
+    SampleStatistics& operator=(const SampleStatistics& that);
+    ~SampleStatistics();
+
+    /**
+     * Record the outcome of one sampled game.
+     * @param numWeeks Number of weeks it took to find the answer.
+     * @param secondsPerWeek Wall time of the game divided by numWeeks.
+     */
+    void record(int numWeeks, double secondsPerWeek);
+
+    long getNumGames() const { return this->numGames; }
+
+    /**
+     * Get the mean number of weeks over the sampled games.
+     * @return Sample mean of the weeks.
+     */
+    double getMeanWeeks() const;
+
+    /**
+     * Get the half width of the 95% confidence interval of the mean weeks,
+     * from the normal approximation.
+     * @return Half width in weeks, or a huge value with fewer than 2 games.
+     */
+    double getMeanWeeksHalfWidth() const;
+
+    /**
+     * Print the weeks distribution, the chance of losing, i.e., needing more
+     * than MAX_WEEKS_TO_WIN weeks, and the time per week, each with a 95%
+     * confidence interval: Wilson intervals for proportions, and normal
+     * intervals for means.
+     * @param out Stream to print to.
+     */
+    void printSummary(std::ostream& out) const;
+};
+
+#endif
@@ -0,0 +1,99 @@
+/**
+ * ScoringPolicy.cpp
+ * Christopher Chute
+ *
+ * Ways to score a candidate guess from its histogram of feedback.
+ */
+
+#include <cmath>
+#include "MinimaxHistograms.h"
+#include "ScoringPolicy.h"
+
+#define ENTROPY_SCALE (65536.0) // Fixed point for count * log2(count).
+
+using std::string;
+
+long scoreHistogram(ScoringPolicy policy, const int* numGivenResponse) {
+    long score = 0;
+    for (int r = 0; r < NUM_RESPONSES; ++r) {
+        long count = numGivenResponse[r];
+        switch (policy) {
+            case EXPECTED_SIZE_SCORE:
+                score += count * count;
+                break;
+            case ENTROPY_SCORE:
+                // Rounded per count, so equal histograms score exactly equal.
+                if (count > 1) {
+                    score += std::lround(count * std::log2(double(count)) * ENTROPY_SCALE);
+                }
+                break;
+            case MOST_PARTS_SCORE:
+                score -= count > 0 ? 1 : 0;
+                break;
+            default:
+                score = count > score ? count : score;
+                break;
+        }
+    }
+    return score;
+}
+
+long getUnsplitScore(ScoringPolicy policy, long numAnswers) {
+    int numGivenResponse[NUM_RESPONSES] = { int(numAnswers) };
+    return scoreHistogram(policy, numGivenResponse);
+}
+
+long combineScores(ScoringPolicy policy, long scoreIfMatch, long scoreIfNoMatch) {
+    if (policy == MINIMAX_SCORE) {
+        return scoreIfMatch > scoreIfNoMatch ? scoreIfMatch : scoreIfNoMatch;
+    }
+    return scoreIfMatch + scoreIfNoMatch;
+}
+
+bool parseScoringPolicy(const string& name, ScoringPolicy* policy) {
+    if (name == "minimax") {
+        *policy = MINIMAX_SCORE;
+    } else if (name == "expected") {
+        *policy = EXPECTED_SIZE_SCORE;
+    } else if (name == "entropy") {
+        *policy = ENTROPY_SCORE;
+    } else if (name == "parts") {
+        *policy = MOST_PARTS_SCORE;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+bool parseScoringPolicies(const string& value, ScoringPolicies* policies) {
+    ScoringPolicy policy;
+    string::size_type equals = value.find('=');
+    if (equals == string::npos) {
+        if (!parseScoringPolicy(value, &policy)) {
+            return false;
+        }
+        for (int stage = 0; stage < NUM_MINIMAX_STAGES; ++stage) {
+            policies->_forStage[stage] = policy;
+        }
+        return true;
+    }
+
+    string stageName = value.substr(0, equals);
+    MinimaxStage stage;
+    if (stageName == "pool") {
+        stage = POOL_MINIMAX;
+    } else if (stageName == "pool-partial") {
+        stage = POOL_AND_PARTIAL_MINIMAX;
+    } else if (stageName == "partial") {
+        stage = PARTIAL_MINIMAX;
+    } else if (stageName == "full") {
+        stage = FULL_MINIMAX;
+    } else {
+        return false;
+    }
+    if (!parseScoringPolicy(value.substr(equals + 1), &policy)) {
+        return false;
+    }
+    policies->_forStage[stage] = policy;
+    return true;
+}
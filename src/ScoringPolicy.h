@@ -0,0 +1,96 @@
+/**
+ * ScoringPolicy.h
+ * Christopher Chute
+ *
+ * Ways to score a candidate guess from its histogram of feedback over the
+ * remaining answers. Every policy reads the same NUM_RESPONSES counts, so
+ * any of them can be used wherever minimax counts a histogram.
+ */
+
+#ifndef GUARD_SCORING_POLICY_H
+#define GUARD_SCORING_POLICY_H
+
+#include <string>
+#include "MinimaxCostModel.h"
+
+/**
+ * How to score a histogram. Lower scores are better under every policy.
+ */
+enum ScoringPolicy {
+    MINIMAX_SCORE,       // Answers left after the worst response.
+    EXPECTED_SIZE_SCORE, // Sum of squared counts, i.e., answers left on average.
+    ENTROPY_SCORE,       // Sum of count * log2(count), i.e., least information.
+    MOST_PARTS_SCORE     // Negated number of responses that can happen.
+};
+
+/**
+ * Policy for each minimax stage. All stages use minimax by default.
+ */
+struct ScoringPolicies {
+    ScoringPolicy _forStage[NUM_MINIMAX_STAGES];
+    ScoringPolicies() {
+        for (int stage = 0; stage < NUM_MINIMAX_STAGES; ++stage) {
+            _forStage[stage] = MINIMAX_SCORE;
+        }
+    }
+};
+
+/**
+ * Score a histogram of feedback.
+ * @param policy How to score it.
+ * @param numGivenResponse NUM_RESPONSES counts, indexed by number correct.
+ * @return Score of the guess with this histogram, lower is better.
+ */
+long scoreHistogram(ScoringPolicy policy, const int* numGivenResponse);
+
+/**
+ * Score a guess that tells none of the answers apart. Minimax only takes
+ * guesses that beat this, so it is where the search for the best starts.
+ * @param policy How to score it.
+ * @param numAnswers Number of remaining answers.
+ * @return Score of a histogram with every answer in one response.
+ */
+long getUnsplitScore(ScoringPolicy policy, long numAnswers);
+
+/**
+ * Score a pair of histograms, one for each side of a Truth Booth: the worse
+ * side under minimax, and the two together under the other policies.
+ * @param policy How the sides were scored.
+ * @param scoreIfMatch Score on the side where the booth is a match.
+ * @param scoreIfNoMatch Score on the other side.
+ * @return Score of the Truth Booth and its guesses.
+ */
+long combineScores(ScoringPolicy policy, long scoreIfMatch, long scoreIfNoMatch);
+
+/**
+ * Check whether a guess beats the best so far: a lower score, or the same
+ * score while being one of the remaining answers when the best is not.
+ * Among guesses alike in both, the first found is kept.
+ * @param score Score of the guess.
+ * @param isAnswer Whether the guess is one of the remaining answers.
+ * @param bestScore Score of the best guess so far.
+ * @param isBestAnswer Whether the best guess so far is a remaining answer.
+ * @return True if the guess should replace the best so far.
+ */
+inline bool isBetterGuess(long score, bool isAnswer, long bestScore, bool isBestAnswer) {
+    return score < bestScore || (score == bestScore && isAnswer && !isBestAnswer);
+}
+
+/**
+ * Read a policy from its name: minimax, expected, entropy or parts.
+ * @param name Name of the policy.
+ * @param policy Where the policy goes, if the name is known.
+ * @return True if the name is known.
+ */
+bool parseScoringPolicy(const std::string& name, ScoringPolicy* policy);
+
+/**
+ * Read policies from a command-line value: a policy name for every stage,
+ * or <stage>=<name> with stage pool, pool-partial, partial or full.
+ * @param value Command-line value.
+ * @param policies Policies to change.
+ * @return True if the value was understood.
+ */
+bool parseScoringPolicies(const std::string& value, ScoringPolicies* policies);
+
+#endif
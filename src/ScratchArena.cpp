@@ -0,0 +1,109 @@
+/**
+ * ScratchArena.cpp
+ * Christopher Chute
+ *
+ * Large-page memory blocks and a resettable bump allocator built on them.
+ */
+
+#include <cstdlib>
+#include <new>
+#include "ScratchArena.h"
+
+#ifdef __linux__
+#include <sys/mman.h>
+#endif
+
+#define HUGE_PAGE_SIZE ((size_t) 2 << 20) // Huge pages are 2 MiB on x86-64.
+
+using std::vector;
+
+size_t roundUpToLargeBlockSize(size_t numBytes) {
+    if (numBytes < HUGE_PAGE_SIZE) {
+        return numBytes;
+    }
+    return (numBytes + HUGE_PAGE_SIZE - 1) & ~(HUGE_PAGE_SIZE - 1);
+}
+
+void* allocateLargeBlock(size_t numBytes) {
+#ifdef __linux__
+    // Prefer explicitly reserved huge pages, then transparent huge pages.
+    numBytes = roundUpToLargeBlockSize(numBytes);
+    void* block = MAP_FAILED;
+    if (numBytes >= HUGE_PAGE_SIZE) {
+        block = mmap(nullptr, numBytes, PROT_READ | PROT_WRITE,
+                     MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    }
+    if (block != MAP_FAILED) {
+        return block;
+    }
+    block = mmap(nullptr, numBytes, PROT_READ | PROT_WRITE,
+                 MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (block == MAP_FAILED) {
+        return nullptr;
+    }
+    if (numBytes >= HUGE_PAGE_SIZE) {
+        madvise(block, numBytes, MADV_HUGEPAGE);
+    }
+    return block;
+#else
+    return calloc(numBytes, 1);
+#endif
+}
+
+void freeLargeBlock(void* block, size_t numBytes) {
+    if (!block) {
+        return;
+    }
+#ifdef __linux__
+    munmap(block, roundUpToLargeBlockSize(numBytes));
+#else
+    (void) numBytes;
+    free(block);
+#endif
+}
+
+ScratchArena::ScratchArena(size_t s) :
+        blocks(new vector<Block>()),
+        blockIndex(0),
+        bytesUsedInBlock(0),
+        minBlockSize(s)
+{}
+
+ScratchArena::~ScratchArena() {
+    for (vector<Block>::iterator it = this->blocks->begin();
+         it != this->blocks->end();
+         ++it) {
+        freeLargeBlock(it->memory, it->capacity);
+    }
+    delete this->blocks;
+}
+
+void* ScratchArena::allocate(size_t numBytes, size_t alignment) {
+    while (this->blockIndex < this->blocks->size()) {
+        Block& block = (*this->blocks)[this->blockIndex];
+        size_t offset = (this->bytesUsedInBlock + alignment - 1) & ~(alignment - 1);
+        if (offset + numBytes <= block.capacity) {
+            this->bytesUsedInBlock = offset + numBytes;
+            return block.memory + offset;
+        }
+        // Doesn't fit, move on to the next block (if any was kept from before).
+        ++this->blockIndex;
+        this->bytesUsedInBlock = 0;
+    }
+
+    Block block;
+    block.capacity = numBytes > this->minBlockSize ? numBytes : this->minBlockSize;
+    block.memory = static_cast<char*>(allocateLargeBlock(block.capacity));
+    if (!block.memory) {
+        throw std::bad_alloc();
+    }
+    this->blocks->push_back(block);
+    this->blockIndex = this->blocks->size() - 1;
+    this->bytesUsedInBlock = numBytes;
+    return block.memory;
+}
+
+void ScratchArena::reset() {
+    this->blockIndex = 0;
+    this->bytesUsedInBlock = 0;
+}
@@ -0,0 +1,79 @@
+/**
+ * ScratchArena.h
+ * Christopher Chute
+ *
+ * Large-page memory blocks and a resettable bump allocator built on them.
+ */
+
+#ifndef GUARD_SCRATCH_ARENA_H
+#define GUARD_SCRATCH_ARENA_H
+
+#include <cstddef>
+#include <vector>
+
+/**
+ * Get the size that allocateLargeBlock actually maps for a request.
+ * @param numBytes Requested size in bytes.
+ * @return numBytes, rounded up to a whole number of huge pages if large.
+ */
+size_t roundUpToLargeBlockSize(size_t numBytes);
+
+/**
+ * Allocate a zero-filled block of memory directly from the operating system,
+ * backed by huge pages where the platform allows it.
+ * @param numBytes Size of the block in bytes.
+ * @return Pointer to the block, or nullptr if it could not be allocated.
+ */
+void* allocateLargeBlock(size_t numBytes);
+
+/**
+ * Release a block returned by allocateLargeBlock.
+ * @param block Pointer returned by allocateLargeBlock.
+ * @param numBytes Size that was passed to allocateLargeBlock.
+ */
+void freeLargeBlock(void* block, size_t numBytes);
+
+/**
+ * Bump allocator for short-lived scratch memory. Individual allocations are
+ * never freed; instead the whole arena is reset, e.g., once per game, so
+ * that its blocks are reused without going back to the operating system.
+ */
+class ScratchArena {
+private:
+    struct Block {
+        char* memory;
+        size_t capacity;
+    };
+    std::vector<Block>* blocks;  // All blocks, reused in order after reset.
+    size_t blockIndex;           // Block currently being allocated from.
+    size_t bytesUsedInBlock;     // Offset of the next free byte in that block.
+    size_t minBlockSize;         // Smallest block to request from the OS.
+public:
+    explicit ScratchArena(size_t minBlockSize);
+    ~ScratchArena();
+
+    /**
+     * Allocate uninitialized memory which stays valid until the next reset.
+     * @param numBytes Number of bytes to allocate.
+     * @param alignment Required alignment, must be a power of two.
+     * @return Pointer to the allocated memory.
+     */
+    void* allocate(size_t numBytes, size_t alignment);
+
+    /**
+     * Allocate an uninitialized array which stays valid until the next reset.
+     * @param count Number of elements in the array.
+     * @return Pointer to the first element.
+     */
+    template<typename T>
+    T* allocateArray(size_t count) {
+        return static_cast<T*>(this->allocate(count * sizeof(T), alignof(T)));
+    }
+
+    /**
+     * Invalidate all allocations, keeping the blocks for reuse.
+     */
+    void reset();
+};
+
+#endif
@@ -0,0 +1,121 @@
+/**
+ * SolverSession.cpp
+ * Christopher Chute
+ *
+ * Headless solver for one season of Are You The One?
+ */
+
+#include <algorithm>
+#include <stdexcept>
+#include "ayto.h"
+#include "ScratchArena.h"
+#include "SolverSession.h"
+
+#define SESSION_BLOCK_SIZE ((size_t) 16 << 20) // Scratch arena block per session.
+
+using std::string;
+
+SolverSession::SolverSession(const SolverOptions& o) :
+        options(o),
+        arena(nullptr),
+        possibleAnswers(nullptr),
+        pmGuessesAlreadyMade(nullptr),
+        tbGuessesAlreadyMade(nullptr),
+        histograms(nullptr),
+        costModel(nullptr)
+{
+    // Without a pool, minimax over many answers has no candidates to score.
+    string poolFilename = o._poolFilename.empty() ? POOL_FILENAME : o._poolFilename;
+    if (!setFixedPoolFilename(poolFilename)) {
+        throw std::runtime_error("Guess pool already read from a file other than " +
+                                 poolFilename + ".");
+    }
+    if (getFixedPool()->size() == 0) {
+        throw std::runtime_error("Could not read guess pool " + poolFilename + ".");
+    }
+
+    this->arena = new ScratchArena(SESSION_BLOCK_SIZE);
+    this->possibleAnswers = new PmSet(this->arena);
+    this->possibleAnswers->populateAll();
+    this->pmGuessesAlreadyMade = new PmSet();
+    this->tbGuessesAlreadyMade = new TbSet();
+
+    int numThreads = o._numThreads > 0 ? o._numThreads : NUM_THREADS;
+    if (o._memoryBudget > 0) {
+        this->histograms = new MinimaxHistograms(numThreads);
+    }
+    if (o._weekBudgetSeconds > 0) {
+        this->costModel = new MinimaxCostModel(o._weekBudgetSeconds,
+                                               std::min(numThreads, NUM_THREADS));
+        this->costModel->calibrate();
+    }
+}
+
+SolverSession::~SolverSession() {
+    delete this->possibleAnswers;
+    delete this->pmGuessesAlreadyMade;
+    delete this->tbGuessesAlreadyMade;
+    delete this->histograms;
+    delete this->costModel;
+    delete this->arena;
+}
+
+Tb SolverSession::nextTruthBooth() const {
+    if (this->possibleAnswers->size() == 0) {
+        return Tb(-1, '_');
+    }
+    return getNextTruthBoothGuess(this->possibleAnswers, this->tbGuessesAlreadyMade);
+}
+
+bool SolverSession::applyTruthBooth(const Tb& truthBooth, bool isMatch) {
+    if (truthBooth.index < 0 || truthBooth.index >= PERM_LENGTH ||
+            truthBooth.charAtIndex < '0' || truthBooth.charAtIndex > '9') {
+        return false;
+    }
+    this->tbGuessesAlreadyMade->add(truthBooth);
+    this->possibleAnswers->filter(truthBooth, isMatch);
+    return true;
+}
+
+Pm SolverSession::nextPerfectMatching() {
+    if (this->possibleAnswers->size() == 0) {
+        return "";
+    }
+
+    MinimaxOptions minimaxOptions;
+    minimaxOptions._costModel = this->costModel;
+    minimaxOptions._numThreads = this->options._numThreads;
+    minimaxOptions._scoringPolicies = this->options._scoringPolicies;
+
+    // Keep histograms only for as many candidates as the budget holds: a
+    // row of counts and a rank per candidate, and a rank per answer.
+    if (this->histograms) {
+        size_t numAnswers = this->possibleAnswers->size();
+        size_t numCandidates = MinimaxCostModel::getNumCandidates(
+                getMinimaxStage(this->possibleAnswers, this->costModel),
+                numAnswers,
+                getFixedPool()->size());
+        size_t numBytes = numCandidates * (NUM_RESPONSES * sizeof(int) + sizeof(PmRank)) +
+                          numAnswers * sizeof(PmRank);
+        if (numBytes <= this->options._memoryBudget) {
+            minimaxOptions._histograms = this->histograms;
+        }
+    }
+
+    return getNextPerfectMatchingGuess(this->possibleAnswers,
+                                       this->pmGuessesAlreadyMade,
+                                       minimaxOptions);
+}
+
+bool SolverSession::applyPerfectMatching(const Pm& perfectMatching, int numCorrect) {
+    if (!isPerfectMatching(perfectMatching) || numCorrect < 0 || numCorrect > PERM_LENGTH) {
+        return false;
+    }
+    this->pmGuessesAlreadyMade->add(perfectMatching);
+    this->possibleAnswers->filter(perfectMatching, numCorrect);
+    return true;
+}
+
+size_t SolverSession::remaining() const {
+    return this->possibleAnswers->size();
+}
@@ -0,0 +1,113 @@
+/**
+ * SolverSession.h
+ * Christopher Chute
+ *
+ * Headless solver for one season of Are You The One?, for programs that
+ * embed the guess generator instead of running ./ayto. A session suggests
+ * guesses and is told the feedback; it never reads or writes the console.
+ */
+
+#ifndef GUARD_SOLVER_SESSION_H
+#define GUARD_SOLVER_SESSION_H
+
+#include <cstddef>
+#include <string>
+#include "PerfectMatching.h"
+#include "PerfectMatchingSet.h"
+#include "ScoringPolicy.h"
+#include "TruthBooth.h"
+#include "TruthBoothSet.h"
+
+class MinimaxCostModel;
+class MinimaxHistograms;
+class ScratchArena;
+
+/**
+ * Resources a session may use. The table of all 10! permutations and the
+ * fixed guess pool are shared by every session in the process and not
+ * counted in the memory budget.
+ */
+struct SolverOptions {
+    int _numThreads;           // Threads for minimax, 0 for one per chunk.
+    size_t _memoryBudget;      // Bytes for histograms kept across weeks, 0 for none.
+    double _weekBudgetSeconds; // Minimax time per guess, 0 for fixed stage thresholds.
+    ScoringPolicies _scoringPolicies; // How each minimax stage scores candidates.
+    std::string _poolFilename; // Fixed guess pool, "" for POOL_FILENAME in ayto.h.
+    SolverOptions() :
+            _numThreads(0),
+            _memoryBudget(0),
+            _weekBudgetSeconds(0),
+            _poolFilename("")
+    {}
+};
+
+class SolverSession {
+private:
+    SolverOptions options;
+    ScratchArena* arena;                      // Backs possibleAnswers.
+    PerfectMatchingSet* possibleAnswers;      // Remaining possibilities.
+    PerfectMatchingSet* pmGuessesAlreadyMade; // Perfect Matchings applied so far.
+    TruthBoothSet* tbGuessesAlreadyMade;      // Truth Booths applied so far.
+    MinimaxHistograms* histograms;            // Set when _memoryBudget > 0.
+    MinimaxCostModel* costModel;              // Set when _weekBudgetSeconds > 0.
+public:
+    /**
+     * Start a season with every matching possible. With a week budget, the
+     * minimax inner loop is timed here, once. The guess pool is read by the
+     * first session and shared by every later one, which must name the same
+     * file.
+     * @param options Threads, memory, time and pool the session may use.
+     * @throws std::runtime_error If the pool file has no guesses, or a
+     * different pool file was already read.
+     */
+    explicit SolverSession(const SolverOptions& options = SolverOptions());
+    ~SolverSession();
+    SolverSession(const SolverSession&) = delete;
+    SolverSession& operator=(const SolverSession&) = delete;
+
+    /**
+     * Suggest the next pair for the Truth Booth.
+     * @return Pair splitting the remaining answers most evenly, or Tb(-1, '_')
+     * if no answers remain.
+     */
+    TruthBooth nextTruthBooth() const;
+
+    /**
+     * Rule out the answers inconsistent with a Truth Booth result.
+     * @param truthBooth Pair that went into the booth, suggested or not.
+     * @param isMatch Whether the pair is a match.
+     * @return False, changing nothing, if truthBooth is not a valid pair.
+     */
+    bool applyTruthBooth(const TruthBooth& truthBooth, bool isMatch);
+
+    /**
+     * Suggest the next Perfect Matching, by minimax.
+     * @return Guess with the lowest worst-case number of answers left, or ""
+     * if no answers remain.
+     */
+    PerfectMatching nextPerfectMatching();
+
+    /**
+     * Rule out the answers inconsistent with a Perfect Matching result.
+     * @param perfectMatching Matching that was submitted, suggested or not.
+     * @param numCorrect Number of correct pairs in it.
+     * @return False, changing nothing, if perfectMatching is not a
+     * permutation of DIGITS or numCorrect is not in [0, PERM_LENGTH].
+     */
+    bool applyPerfectMatching(const PerfectMatching& perfectMatching, int numCorrect);
+
+    /**
+     * Get the number of answers still possible. Zero means the feedback
+     * applied so far contradicts itself.
+     * @return Number of remaining answers.
+     */
+    size_t remaining() const;
+
+    /**
+     * Get the answers still possible.
+     * @return Remaining answers, owned by the session.
+     */
+    const PerfectMatchingSet* getPossibleAnswers() const { return this->possibleAnswers; }
+};
+
+#endif
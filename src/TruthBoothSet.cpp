@@ -13,8 +13,18 @@ using std::vector;
 
 typedef TruthBooth Tb;
 
+// Bit of a pair in isAdded, or -1 for a booth outside the 100 pairs.
+static int getPairIndex(const Tb& m) {
+    int digit = m.charAtIndex - '0';
+    if (m.index < 0 || m.index >= PERM_LENGTH || digit < 0 || digit >= PERM_LENGTH) {
+        return -1;
+    }
+    return PERM_LENGTH * m.index + digit;
+}
+
 TruthBoothSet::TruthBoothSet() {
     this->data = new vector<Tb>();
+    this->isAdded[0] = this->isAdded[1] = 0;
 }
 
 TruthBoothSet::~TruthBoothSet() {
@@ -23,11 +33,18 @@ TruthBoothSet::~TruthBoothSet() {
 
 void TruthBoothSet::add(const Tb& m) {
     this->data->push_back(m);
+    int pair = getPairIndex(m);
+    if (pair >= 0) {
+        this->isAdded[pair / 64] |= 1ULL << (pair % 64);
+    }
 }
 
 bool TruthBoothSet::contains(const Tb& m) const {
-    return find(this->data->begin(), this->data->end(), m)
-           != this->data->end();
+    int pair = getPairIndex(m);
+    if (pair < 0) {
+        return find(this->data->begin(), this->data->end(), m) != this->data->end();
+    }
+    return (this->isAdded[pair / 64] >> (pair % 64)) & 1;
 }
 
 Tb& TruthBoothSet::get(int i) const {
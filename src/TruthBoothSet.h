@@ -8,12 +8,14 @@
 #ifndef GUARD_TRUTH_BOOTH_SET_H
 #define GUARD_TRUTH_BOOTH_SET_H
 
+#include <cstdint>
 #include <vector>
 #include "TruthBooth.h"
 
 class TruthBoothSet {
 private:
     std::vector<TruthBooth>* data;
+    uint64_t isAdded[2];        // Bit 10 * index + digit, for each of the 100 pairs.
 public:
     TruthBoothSet();
     ~TruthBoothSet();
@@ -25,7 +27,8 @@ public:
     void add(const TruthBooth& truthBooth);
 
     /**
-     * Check whether this container contains a specific element.
+     * Check whether this container contains a specific element, in
+     * constant time.
      * @param truthBooth Element to search for in this container.
      * @return True if this container contains truthBooth, false otherwise.
      */
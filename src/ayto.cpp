@@ -6,82 +6,154 @@
  */
 
 #include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <climits>
+#include <cstdio>
 #include <cstdlib>
 #include <cstring>
+#include <ctime>
 #include <iostream>
 #include <iomanip>
+#include <mutex>
+#include <set>
 #include <sstream>
 #include <thread>
+#include <unistd.h>
 #include "ayto.h"
+#include "AnswerTrie.h"
+#include "GuessSpeculator.h"
+#include "NumaTopology.h"
+#include "OptimalSolver.h"
+#include "PerfectMatchingUniverse.h"
+#include "RunResults.h"
+#include "SampleStatistics.h"
 
-#define DIGITS ("0123456789") // Available digits for a permutation.
+#define CHECKPOINT_SECONDS (60) // Seconds between checkpoints in -a mode.
+#define MIN_SAMPLES (30)        // Games before --ci-width may stop sampling.
 #define GUESS  ("4579108623") // The fixed guess made in the second turn.
-#define NUM_THREADS (10)      // Number of threads to use during minimax.
-#define PERM_LENGTH (10)      // Number of elements in a permutation.
-#define POOL_FILENAME ("scripts/pool.txt") // Location of fixed guess pool.
 #define START_FULL_MM (314)   // Start w/ full minimax when <= this # left.
 #define START_PART_MM (10000) // Start partial minimax when <= this # left.
+#define SCRATCH_BLOCK_SIZE ((size_t) 16 << 20) // Per-game scratch arena block.
 
 using std::abs;
 using std::cout;
 using std::cin;
 using std::endl;
 using std::flush;
+using std::ostream;
 using std::pair;
-using std::rand;
+using std::set;
 using std::setw;
-using std::srand;
 using std::string;
 using std::stringstream;
 using std::thread;
 using std::vector;
 
-int main(int argc, char** argv) {
-    AytoSettings* settings = new AytoSettings();
+static string fixedPoolFilename = POOL_FILENAME; // Read by getFixedPool.
+static bool isFixedPoolRead = false;             // Set once getFixedPool has run.
 
-    if (settings->initializeFromArgs(argc, argv)) {
-        if (settings->_isAllPermutationsMode) {
-            cout << "Running on all possible answers." << endl;
-            PerfectMatching answer = DIGITS;
-            do {
-                runAreYouTheOne(answer, settings);
-            } while (next_permutation(answer.begin(), answer.end()));
-        } else if (settings->_isReadFromFileMode) {
-            cout << "Reading answers from " << settings->_fileToRead << "." << endl;
-            PmSet *answers = new PmSet();
-            answers->populateFromFile(settings->_fileToRead);
-            for (PmSet::const_iterator answer = answers->begin();
-                 answer != answers->end();
-                 ++answer) {
-                runAreYouTheOne(*answer, settings);
-            }
-            delete answers;
-        } else if (settings->_isInteractiveMode) {
-            cout << "Interactive mode. I think I'm going to win." << endl;
-            runAreYouTheOne("", settings);
-        } else {
-            cout << "Running on a random answer." << endl;
-            std::srand(unsigned(std::time(nullptr)));
-            Pm answer = getRandomPerfectMatching();
-            runAreYouTheOne(answer, settings);
+bool AreYouTheOneSettings::initializeFromArgs(int argc, char** argv) {
+    if (argc > 1 && strncmp(argv[1], "merge", 6) == 0) {
+        // Merge subcommand: output file, then one or more results files.
+        if (argc < 4) {
+            return false;
         }
-    } else {
-        cout << "usage: ./ayto" << endl;
-        cout << "\t[-a | -all]     * Run on all permutations" << endl;
-        cout << "\t[-f <filename>] * Run on permutations in file" << endl;
-        cout << "\t[-i]            * Interactive, user gives feedback" << endl;
-        cout << "\t[-v]            * Verbose mode, more printing" << endl;
+        this->_isMergeMode = true;
+        this->_checkpointFile = argv[2];
+        this->_filesToMerge.assign(argv + 3, argv + argc);
+        return true;
     }
 
-    delete settings;
-
-    return EXIT_SUCCESS;
-}
-
-bool AreYouTheOneSettings::initializeFromArgs(int argc, char** argv) {
     for (int i = 1; i < argc; ++i) {
         if (strncmp(argv[i], "-a", 3) == 0) {
             this->_isAllPermutationsMode = true;
+        } else if (strncmp(argv[i], "--shard", 8) == 0) {
+            if (++i == argc ||
+                    sscanf(argv[i], "%d/%d", &this->_shardIndex, &this->_numShards) != 2 ||
+                    this->_numShards < 1 ||
+                    this->_shardIndex < 0 ||
+                    this->_shardIndex >= this->_numShards) {
+                return false;
+            }
+        } else if (strncmp(argv[i], "--checkpoint", 13) == 0) {
+            if (++i == argc) {
+                return false;
+            }
+            this->_checkpointFile = argv[i];
+        } else if (strncmp(argv[i], "--resume", 9) == 0) {
+            this->_isResumeMode = true;
+        } else if (strncmp(argv[i], "--incremental", 14) == 0) {
+            this->_isIncrementalMode = true;
+        } else if (strncmp(argv[i], "--workers", 10) == 0) {
+            if (++i == argc || (this->_numWorkers = atoi(argv[i])) < 1) {
+                return false;
+            }
+        } else if (strncmp(argv[i], "--worker-timeout", 17) == 0) {
+            if (++i == argc || (this->_workerTimeoutSeconds = atoi(argv[i])) < 1) {
+                return false;
+            }
+        } else if (strncmp(argv[i], "--budget", 9) == 0) {
+            if (++i == argc || (this->_weekBudgetSeconds = atof(argv[i])) <= 0) {
+                return false;
+            }
+        } else if (strncmp(argv[i], "--lookahead", 12) == 0) {
+            if (++i == argc || (this->_numLookaheadBooths = atoi(argv[i])) < 1) {
+                return false;
+            }
+        } else if (strncmp(argv[i], "--score", 8) == 0) {
+            if (++i == argc || !parseScoringPolicies(argv[i], &this->_scoringPolicies)) {
+                return false;
+            }
+        } else if (strncmp(argv[i], "--sample", 9) == 0) {
+            if (++i == argc || (this->_numSamples = atoi(argv[i])) < 1) {
+                return false;
+            }
+        } else if (strncmp(argv[i], "--parallel", 11) == 0) {
+            if (++i == argc || (this->_numParallelGames = atoi(argv[i])) < 1) {
+                return false;
+            }
+        } else if (strncmp(argv[i], "--ci-width", 11) == 0) {
+            if (++i == argc || (this->_targetWidth = atof(argv[i])) <= 0) {
+                return false;
+            }
+        } else if (strncmp(argv[i], "--numa", 7) == 0) {
+            this->_isNumaMode = true;
+        } else if (strncmp(argv[i], "--worker", 9) == 0) {
+            this->_isWorkerMode = true;
+        } else if (strncmp(argv[i], "--build-pool", 13) == 0) {
+            if (++i == argc) {
+                return false;
+            }
+            this->_isBuildPoolMode = true;
+            this->_poolBuilder._outputFile = argv[i];
+        } else if (strncmp(argv[i], "--pool-size", 12) == 0) {
+            if (++i == argc || (this->_poolBuilder._poolSize = atoi(argv[i])) < 1) {
+                return false;
+            }
+        } else if (strncmp(argv[i], "--pool-candidates", 18) == 0) {
+            if (++i == argc || (this->_poolBuilder._numCandidates = atoi(argv[i])) < 0) {
+                return false;
+            }
+        } else if (strncmp(argv[i], "--seed", 7) == 0) {
+            if (++i == argc) {
+                return false;
+            }
+            this->_seed = unsigned(strtoul(argv[i], nullptr, 10));
+        } else if (strncmp(argv[i], "--solve-tree", 13) == 0) {
+            if (++i == argc) {
+                return false;
+            }
+            this->_solveTreeFile = argv[i];
+        } else if (strncmp(argv[i], "--solve-below", 14) == 0) {
+            if (++i == argc || (this->_solveBelow = atoi(argv[i])) < 1) {
+                return false;
+            }
+        } else if (strncmp(argv[i], "--tree", 7) == 0) {
+            if (++i == argc) {
+                return false;
+            }
+            this->_treeFile = argv[i];
         } else if (strncmp(argv[i], "-f", 3) == 0) {
             this->_isReadFromFileMode = true;
             if (++i == argc) {
@@ -94,6 +166,20 @@ bool AreYouTheOneSettings::initializeFromArgs(int argc, char** argv) {
             this->_isVerboseMode = true;
         } else if (strncmp(argv[i], "-n", 3) == 0) {
             this->_isPrintNumbersMode = true;
+        } else if (strncmp(argv[i], "-q", 3) == 0) {
+            this->_isQuietMode = true;
+        } else if (strncmp(argv[i], "-o", 3) == 0) {
+            if (++i == argc) {
+                return false;
+            }
+            this->_isQuietMode = true;
+            this->_resultsFile = argv[i];
+        } else if (strncmp(argv[i], "-b", 3) == 0) {
+            this->_isBinaryResults = true;
+        } else if (strncmp(argv[i], "-t", 3) == 0) {
+            if (++i == argc || (this->_transcriptMinWeeks = atoi(argv[i])) < 0) {
+                return false;
+            }
         } else {
             return false;
         }
@@ -129,10 +215,380 @@ bool AreYouTheOneSettings::initializeFromArgs(int argc, char** argv) {
         };
     }
 
+    if (this->_isBinaryResults && this->_resultsFile.empty()) {
+        return false; // Binary records need a file of their own.
+    }
+
+    // Sharded and resumable runs always keep a results file.
+    if (this->_checkpointFile.empty() &&
+            (this->_numShards > 1 || this->_isResumeMode)) {
+        stringstream defaultName;
+        defaultName << "ayto-shard-" << this->_shardIndex
+                    << "-of-" << this->_numShards << ".txt";
+        this->_checkpointFile = defaultName.str();
+    }
+
     return true;
 }
 
-Pm getNextPerfectMatchingGuess(const PmSet* possibleAnswers, const PmSet* guessesAlreadyMade)
+void runAllAnswers(const AytoSettings* settings)
+{
+    const PerfectMatchingUniverse& universe = PerfectMatchingUniverse::get();
+    RunResults results(settings->_shardIndex, settings->_numShards);
+    bool isCheckpointing = !settings->_checkpointFile.empty();
+
+    if (settings->_isResumeMode) {
+        RunResults saved(settings->_shardIndex, settings->_numShards);
+        if (!saved.loadFromFile(settings->_checkpointFile)) {
+            cout << "No checkpoint in " << settings->_checkpointFile
+                 << ", starting from the beginning." << endl;
+        } else if (saved.getFirstRank() != results.getFirstRank() ||
+                   saved.getEndRank() != results.getEndRank()) {
+            cout << "Checkpoint " << settings->_checkpointFile
+                 << " is for a different shard. Nothing done." << endl;
+            return;
+        } else {
+            results = saved;
+        }
+
+        // Records of games played after the checkpoint are played again.
+        size_t numPlayed = size_t(results.getNextRank() - results.getFirstRank());
+        if (settings->_resultWriter && !settings->_resultWriter->truncateToRecords(numPlayed)) {
+            cout << "Results file " << settings->_resultsFile << " holds fewer than the "
+                 << numPlayed << " games in the checkpoint. Nothing done." << endl;
+            return;
+        }
+    }
+
+    cout << "Running on all possible answers";
+    if (settings->_numShards > 1) {
+        cout << " in shard " << settings->_shardIndex << "/" << settings->_numShards;
+    }
+    cout << " (ranks " << results.getNextRank() << " to " << results.getEndRank()
+         << ")." << endl;
+
+    time_t lastCheckpoint = time(nullptr);
+    for (PmRank rank = results.getNextRank(); rank < results.getEndRank(); ++rank) {
+        const Pm& answer = universe.at(rank);
+        results.record(answer, runAreYouTheOne(answer, settings));
+
+        if (isCheckpointing && time(nullptr) - lastCheckpoint >= CHECKPOINT_SECONDS) {
+            if (settings->_resultWriter) {
+                settings->_resultWriter->flush();
+            }
+            if (!results.saveToFile(settings->_checkpointFile)) {
+                cout << "Could not write checkpoint " << settings->_checkpointFile
+                     << "." << endl;
+            }
+            lastCheckpoint = time(nullptr);
+        }
+    }
+
+    if (settings->_resultWriter) {
+        settings->_resultWriter->flush();
+    }
+    if (isCheckpointing && !results.saveToFile(settings->_checkpointFile)) {
+        cout << "Could not write results " << settings->_checkpointFile << "." << endl;
+    }
+    results.printSummary(cout);
+}
+
+// State shared by the game threads of runSampledAnswers.
+struct SampledGames {
+    const AytoSettings* _settings;
+    const vector<Pm>* _answers;
+    std::atomic<int> _nextIndex;          // Next answer to start.
+    std::atomic<bool> _isDone;            // Target width reached, start no more.
+    std::mutex _mutex;                    // Guards everything below.
+    vector<int> _weeks;                   // Per answer, 0 until played.
+    vector<double> _secondsPerWeek;
+    int _numRecorded;                     // Answers [0, _numRecorded) are in _stats.
+    SampleStatistics _stats;
+};
+
+static void playSampledGamesOnThread(SampledGames* games)
+{
+    int numAnswers = int(games->_answers->size());
+    const AytoSettings* settings = games->_settings;
+    while (!games->_isDone) {
+        int index = games->_nextIndex++;
+        if (index >= numAnswers) {
+            break;
+        }
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        int numWeeks = runAreYouTheOne(games->_answers->at(index), settings);
+        std::chrono::duration<double> seconds = std::chrono::steady_clock::now() - start;
+
+        // Record in the order answers were drawn, so that where sampling
+        // stops does not depend on which games happened to finish first.
+        std::lock_guard<std::mutex> lock(games->_mutex);
+        games->_weeks[index] = numWeeks;
+        games->_secondsPerWeek[index] = seconds.count() / std::max(numWeeks, 1);
+        while (!games->_isDone && games->_numRecorded < numAnswers &&
+               games->_weeks[games->_numRecorded] > 0) {
+            games->_stats.record(games->_weeks[games->_numRecorded],
+                                 games->_secondsPerWeek[games->_numRecorded]);
+            ++games->_numRecorded;
+            if (settings->_targetWidth > 0 && games->_numRecorded >= MIN_SAMPLES &&
+                2 * games->_stats.getMeanWeeksHalfWidth() <= settings->_targetWidth) {
+                games->_isDone = true;
+            }
+        }
+    }
+}
+
+void runSampledAnswers(const AytoSettings* settings)
+{
+    // Draw every answer up front: the sample depends only on the seed.
+    std::mt19937 rng(settings->_seed);
+    vector<Pm> answers;
+    for (int i = 0; i < settings->_numSamples; ++i) {
+        answers.push_back(getRandomPerfectMatching(&rng));
+    }
+
+    SampledGames games;
+    games._settings = settings;
+    games._answers = &answers;
+    games._nextIndex = 0;
+    games._isDone = false;
+    games._weeks.assign(answers.size(), 0);
+    games._secondsPerWeek.assign(answers.size(), 0);
+    games._numRecorded = 0;
+
+    // Workers serve one minimax at a time, so games share them in turn.
+    int numGames = settings->_minimaxCoordinator ? 1 : std::max(settings->_numParallelGames, 1);
+    numGames = std::min(numGames, settings->_numSamples);
+    cout << "Running on " << settings->_numSamples << " random answers (seed "
+         << settings->_seed << "), " << numGames << " at a time." << endl;
+
+    vector<thread> threads;
+    for (int t = 1; t < numGames; ++t) {
+        threads.push_back(thread(playSampledGamesOnThread, &games));
+    }
+    playSampledGamesOnThread(&games);
+    for (size_t t = 0; t < threads.size(); ++t) {
+        threads[t].join();
+    }
+
+    if (settings->_resultWriter) {
+        settings->_resultWriter->flush();
+    }
+    if (games._numRecorded < settings->_numSamples) {
+        cout << "Confidence interval narrow enough after " << games._numRecorded
+             << " of " << settings->_numSamples << " answers." << endl;
+    }
+    games._stats.printSummary(cout);
+}
+
+// Value of the usual strategy from the start of a week, over every answer
+// and every response, counted the way the optimal solver counts it.
+static OptimalValue getGreedyValue(const PmSet* possibleAnswers,
+                                   const TbSet* tbGuessesAlreadyMade,
+                                   const PmSet* pmGuessesAlreadyMade,
+                                   const MinimaxOptions& options)
+{
+    OptimalValue value;
+    Tb truthBooth = getNextTruthBoothGuess(possibleAnswers, tbGuessesAlreadyMade);
+    TbSet tbGuesses;
+    for (size_t i = 0; i < tbGuessesAlreadyMade->size(); ++i) {
+        tbGuesses.add(tbGuessesAlreadyMade->get(int(i)));
+    }
+    tbGuesses.add(truthBooth);
+
+    for (int isMatch = 0; isMatch < 2; ++isMatch) {
+        PmSet afterTb(possibleAnswers->begin(), possibleAnswers->end());
+        afterTb.filter(truthBooth, isMatch == 1);
+        if (afterTb.size() == 0) {
+            continue;
+        }
+        Pm perfectMatching = getNextPerfectMatchingGuess(&afterTb, pmGuessesAlreadyMade, options);
+        PmSet pmGuesses(pmGuessesAlreadyMade->begin(), pmGuessesAlreadyMade->end());
+        pmGuesses.add(perfectMatching);
+
+        for (int numCorrect = 0; numCorrect <= PERM_LENGTH; ++numCorrect) {
+            PmSet afterPm(afterTb.begin(), afterTb.end());
+            afterPm.filter(perfectMatching, numCorrect);
+            if (afterPm.size() == 0) {
+                continue;
+            }
+            if (numCorrect == PERM_LENGTH) {
+                value._worstWeeks = std::max(value._worstWeeks, 1);
+                value._totalWeeks += 1;
+            } else {
+                OptimalValue next = getGreedyValue(&afterPm, &tbGuesses, &pmGuesses, options);
+                value._worstWeeks = std::max(value._worstWeeks, 1 + next._worstWeeks);
+                value._totalWeeks += next._totalWeeks + long(afterPm.size());
+            }
+        }
+    }
+    return value;
+}
+
+void runOptimalSolver(const PmSet* answers, const AytoSettings* settings)
+{
+    // Histograms are for one game going forward, not a tree of them.
+    MinimaxOptions minimaxOptions;
+    minimaxOptions._coordinator = settings->_minimaxCoordinator;
+    minimaxOptions._costModel = settings->_costModel;
+    minimaxOptions._scoringPolicies = settings->_scoringPolicies;
+    minimaxOptions._isNumaAware = settings->_isNumaMode;
+    OptimalSolver solver(NUM_THREADS, OPTIMAL_EXTRA_CANDIDATES);
+    DecisionTree tree;
+    if (tree.loadFromFile(settings->_solveTreeFile)) {
+        cout << "Adding to the " << tree.size() << " moves in "
+             << settings->_solveTreeFile << "." << endl;
+    }
+
+    set<uint64_t> solvedStates;
+    long numAnswers = 0;
+    int optimalWorst = 0;
+    int greedyWorst = 0;
+    double optimalTotal = 0;
+    double greedyTotal = 0;
+    cout << std::fixed << std::setprecision(3);
+
+    for (PmSet::const_iterator answer = answers->begin(); answer != answers->end(); ++answer) {
+        // Play the usual strategy until the end game is small enough.
+        PmSet possibleAnswers;
+        possibleAnswers.populateAll();
+        TbSet tbGuessesAlreadyMade;
+        PmSet pmGuessesAlreadyMade;
+        int numWeeksPlayed = 0;
+        bool isWon = false;
+        while (possibleAnswers.size() > size_t(settings->_solveBelow) && !isWon) {
+            Tb truthBooth = getNextTruthBoothGuess(&possibleAnswers, &tbGuessesAlreadyMade);
+            tbGuessesAlreadyMade.add(truthBooth);
+            possibleAnswers.filter(truthBooth, truthBooth.isContainedIn(*answer));
+            Pm perfectMatching = getNextPerfectMatchingGuess(&possibleAnswers,
+                                                             &pmGuessesAlreadyMade,
+                                                             minimaxOptions);
+            pmGuessesAlreadyMade.add(perfectMatching);
+            int numCorrect = numInCommon(perfectMatching, *answer);
+            possibleAnswers.filter(perfectMatching, numCorrect);
+            ++numWeeksPlayed;
+            isWon = numCorrect == PERM_LENGTH;
+        }
+
+        cout << *answer << ": ";
+        if (isWon) {
+            cout << "won in week " << numWeeksPlayed << ", before the end game." << endl;
+            continue;
+        }
+        if (!solvedStates.insert(possibleAnswers.hash()).second) {
+            cout << "same end game as an earlier answer." << endl;
+            continue;
+        }
+
+        size_t numLeft = possibleAnswers.size();
+        OptimalValue optimal = solver.solve(&possibleAnswers);
+        solver.addMoves(&possibleAnswers, &tree);
+        OptimalValue greedy = getGreedyValue(&possibleAnswers,
+                                             &tbGuessesAlreadyMade,
+                                             &pmGuessesAlreadyMade,
+                                             minimaxOptions);
+
+        // Weeks are counted from the start of the game.
+        cout << "week " << (numWeeksPlayed + 1) << " starts with " << numLeft << " left."
+             << " Optimal: worst " << (numWeeksPlayed + optimal._worstWeeks)
+             << ", mean " << (numWeeksPlayed + double(optimal._totalWeeks) / numLeft) << "."
+             << " Usual: worst " << (numWeeksPlayed + greedy._worstWeeks)
+             << ", mean " << (numWeeksPlayed + double(greedy._totalWeeks) / numLeft) << "."
+             << endl;
+        numAnswers += long(numLeft);
+        optimalWorst = std::max(optimalWorst, numWeeksPlayed + optimal._worstWeeks);
+        greedyWorst = std::max(greedyWorst, numWeeksPlayed + greedy._worstWeeks);
+        optimalTotal += double(numWeeksPlayed) * numLeft + optimal._totalWeeks;
+        greedyTotal += double(numWeeksPlayed) * numLeft + greedy._totalWeeks;
+    }
+
+    if (numAnswers > 0) {
+        cout << "Over the " << numAnswers << " answers of " << solvedStates.size()
+             << " end games. Optimal: worst " << optimalWorst
+             << ", mean " << (optimalTotal / numAnswers) << "."
+             << " Usual: worst " << greedyWorst
+             << ", mean " << (greedyTotal / numAnswers) << "." << endl;
+    }
+    cout << solver.getNumStatesSolved() << " distinct states solved, "
+         << tree.size() << " moves in the tree." << endl;
+    if (!tree.saveToFile(settings->_solveTreeFile)) {
+        cout << "Could not write tree " << settings->_solveTreeFile << "." << endl;
+    }
+}
+
+void mergeResultFiles(const AytoSettings* settings)
+{
+    RunResults merged(0, 1);
+    vector<pair<PmRank, PmRank> > ranges; // Rank ranges covered by the inputs.
+    long numMissing = 0;
+
+    for (vector<string>::const_iterator it = settings->_filesToMerge.begin();
+         it != settings->_filesToMerge.end();
+         ++it) {
+        RunResults shard(0, 1);
+        if (!shard.loadFromFile(*it)) {
+            cout << "Could not read results " << *it << ". Nothing done." << endl;
+            return;
+        }
+        if (!shard.isComplete()) {
+            cout << *it << ": shard " << shard.getShardIndex() << "/"
+                 << shard.getNumShards() << " is incomplete, "
+                 << (shard.getEndRank() - shard.getNextRank()) << " answers left." << endl;
+        }
+        // A shard that never started covers nothing, wherever its range begins.
+        if (shard.getNextRank() > shard.getFirstRank()) {
+            ranges.push_back(pair<PmRank, PmRank>(shard.getFirstRank(), shard.getNextRank()));
+        }
+        merged.merge(shard);
+    }
+
+    // Shards may come from runs with different N, so check the ranges
+    // themselves for overlaps and holes rather than the shard indices.
+    sort(ranges.begin(), ranges.end());
+    PmRank covered = 0;
+    PmRank firstHole = NUM_PERMS;
+    for (vector<pair<PmRank, PmRank> >::const_iterator it = ranges.begin();
+         it != ranges.end();
+         ++it) {
+        if (it->first < covered) {
+            cout << "Results overlap at rank " << it->first << ". Nothing done." << endl;
+            return;
+        }
+        if (it->first > covered && firstHole == NUM_PERMS) {
+            firstHole = covered;
+        }
+        numMissing += it->first - covered;
+        covered = it->second;
+    }
+    bool isHoleBeforeEnd = firstHole != NUM_PERMS;
+    if (covered < NUM_PERMS && firstHole == NUM_PERMS) {
+        firstHole = covered;
+    }
+    numMissing += NUM_PERMS - covered;
+
+    // The merged file resumes, like any shard, from its first unplayed rank.
+    // Resuming before a hole would play the ranks after it a second time.
+    if (isHoleBeforeEnd) {
+        merged.printSummary(cout);
+        cout << numMissing << " answers have not been played yet, starting at rank "
+             << firstHole << ". Play them and merge again; "
+             << settings->_checkpointFile << " not written." << endl;
+        return;
+    }
+    merged.setRanks(0, firstHole, NUM_PERMS);
+
+    if (!merged.saveToFile(settings->_checkpointFile)) {
+        cout << "Could not write results " << settings->_checkpointFile << "." << endl;
+        return;
+    }
+    merged.printSummary(cout);
+    if (numMissing > 0) {
+        cout << numMissing << " answers have not been played yet." << endl;
+    }
+}
+
+Pm getNextPerfectMatchingGuess(const PmSet* possibleAnswers,
+                               const PmSet* guessesAlreadyMade,
+                               const MinimaxOptions& options)
 {
     if (possibleAnswers->size() == 1) {
         return possibleAnswers->get(0);
@@ -144,7 +600,7 @@ Pm getNextPerfectMatchingGuess(const PmSet* possibleAnswers, const PmSet* guesse
         case 1:
             return GUESS;
         default:
-            return getNextGuessUsingMinimax(possibleAnswers, guessesAlreadyMade);
+            return getNextGuessUsingMinimax(possibleAnswers, guessesAlreadyMade, options);
     }
 }
 
@@ -193,43 +649,149 @@ Tb getNextTruthBoothGuess(const PmSet* possibleAnswers, const TbSet* guessesAlre
     return nextGuess;
 }
 
-Pm getNextGuessUsingMinimax(const PmSet* possibleAnswers, const PmSet* guessesAlreadyMade)
+// Candidate guesses of a minimax stage. Sets built for the stage go in storage.
+static const PmSet* getCandidatesForStage(MinimaxStage stage,
+                                          const PmSet* possibleAnswers,
+                                          PmSet* storage)
+{
+    switch (stage) {
+        case POOL_MINIMAX: {
+            // Select the best guess from a fixed pool of possibilities.
+            return getFixedPool();
+        }
+        case PARTIAL_MINIMAX: {
+            // Select the best guess from the possible remaining solutions.
+            return possibleAnswers;
+        }
+        case POOL_AND_PARTIAL_MINIMAX: {
+            // Select the best guess from the pool, then the remaining
+            // solutions that are not already in it.
+            const PmSet* pool = getFixedPool();
+            vector<PmRank> sortedPool;
+            for (PmSet::const_iterator it = pool->begin(); it != pool->end(); ++it) {
+                storage->addRank(it.rank());
+                sortedPool.push_back(it.rank());
+            }
+            sort(sortedPool.begin(), sortedPool.end());
+            for (PmSet::const_iterator it = possibleAnswers->begin();
+                 it != possibleAnswers->end();
+                 ++it) {
+                if (!binary_search(sortedPool.begin(), sortedPool.end(), it.rank())) {
+                    storage->addRank(it.rank());
+                }
+            }
+            return storage;
+        }
+        default: {
+            // Select the best guess from all possible permutations.
+            storage->populateAll();
+            return storage;
+        }
+    }
+}
+
+// Evaluate every stride-th chunk, starting at first, on the calling thread.
+// Pinned threads stay on one NUMA node, so their chunks are all node-local,
+// and each builds its own trie of the answers there instead of sharing one.
+static void evaluateChunksOnThread(const vector<ArgsForMinimaxThread*>* argsForChunks,
+                                   int first,
+                                   int stride,
+                                   bool isPinned)
+{
+    AnswerTrie* localTrie = nullptr;
+    if (isPinned) {
+        NumaTopology::get().pinThread();
+        localTrie = new AnswerTrie((*argsForChunks)[size_t(first)]->_possibleAnswers);
+    }
+    for (size_t i = size_t(first); i < argsForChunks->size(); i += size_t(stride)) {
+        if (localTrie) {
+            (*argsForChunks)[i]->_answerTrie = localTrie;
+        }
+        getBestGuessFromSubset((*argsForChunks)[i]);
+    }
+    delete localTrie;
+}
+
+Pm getNextGuessUsingMinimax(const PmSet* possibleAnswers,
+                            const PmSet* guessesAlreadyMade,
+                            const MinimaxOptions& options)
 {
     // Spin up threads to run minimax in parallel.
-    map<Pm, int>* bestGuessFromEachThread = new map<Pm, int>();
-    mutex* writeLock = new mutex();
     vector<thread> minimaxThreads;
     vector<ArgsForMinimaxThread*> argsForMinimaxThreads;
-    PmSet** chunksToEvaluate;
-
-    if (possibleAnswers->size() > START_PART_MM) {
-        // Select the best guess from a fixed pool of possibilities.
-        PmSet* fixedPoolToEvaluate = new PmSet();
-        fixedPoolToEvaluate->populateFromFile(POOL_FILENAME);
-        chunksToEvaluate = fixedPoolToEvaluate->copyIntoChunks(NUM_THREADS);
-        delete fixedPoolToEvaluate;
-    } else if (possibleAnswers->size() > START_FULL_MM) {
-        // Select the best guess from the possible remaining solutions.
-        chunksToEvaluate = possibleAnswers->copyIntoChunks(NUM_THREADS);
+    MinimaxStage stage = getMinimaxStage(possibleAnswers, options._costModel);
+    ScoringPolicy scoringPolicy = options._scoringPolicies._forStage[stage];
+    PmSet candidateStorage;
+    const PmSet* candidates = getCandidatesForStage(stage, possibleAnswers, &candidateStorage);
+    bool isEvaluatedFromHistograms = options._histograms && stage != FULL_MINIMAX;
+    bool isEvaluatedByWorkers = !isEvaluatedFromHistograms && options._coordinator &&
+            options._coordinator->getNumUnits() > 0;
+    // Chunks become work units when there are worker processes to take them,
+    // several for each worker so none sits idle while the last units finish.
+    int numChunks = isEvaluatedByWorkers ?
+            std::max(options._coordinator->getNumUnits(), NUM_THREADS) : NUM_THREADS;
+    PmSet** chunksToEvaluate = candidates->copyIntoChunks(numChunks);
+    const GuessHistory history(guessesAlreadyMade);
+    vector<pair<Pm, long> > bestGuessFromEachChunk(numChunks);
+    vector<int> chunksForThreads;
+
+    // Histograms kept from last week are cheaper to update than to recount,
+    // as long as there are few enough candidates to keep them for.
+    if (isEvaluatedFromHistograms) {
+        options._histograms->update(candidates, possibleAnswers);
+        getBestGuessesFromHistograms(options._histograms,
+                                     chunksToEvaluate,
+                                     numChunks,
+                                     &history,
+                                     possibleAnswers->size(),
+                                     scoringPolicy,
+                                     &bestGuessFromEachChunk);
+    } else if (isEvaluatedByWorkers) {
+        // Units the workers could not finish are left for the threads.
+        options._coordinator->evaluateChunks(possibleAnswers,
+                                             guessesAlreadyMade,
+                                             chunksToEvaluate,
+                                             numChunks,
+                                             scoringPolicy,
+                                             &bestGuessFromEachChunk,
+                                             &chunksForThreads);
     } else {
-        // Select the best guess from all possible permutations.
-        cout << "    Full minimax... May take up to one minute." << endl;
-        PmSet* allPossible = new PmSet();
-        allPossible->populateAll();
-        chunksToEvaluate = allPossible->copyIntoChunks(NUM_THREADS);
-        delete allPossible;
+        for (int id = 0; id < numChunks; ++id) {
+            chunksForThreads.push_back(id);
+        }
     }
+    bool isNumaAware = options._isNumaAware && NumaTopology::get().getNumNodes() > 1;
 
-    for (int id = 0; id < NUM_THREADS; ++id) {
+    // The threads walk one trie of the answers, built once for the decision,
+    // unless pinned ones build their own on their nodes.
+    AnswerTrie* answerTrie = !chunksForThreads.empty() && !isNumaAware ?
+            new AnswerTrie(possibleAnswers) : nullptr;
+    for (vector<int>::const_iterator it = chunksForThreads.begin();
+         it != chunksForThreads.end();
+         ++it) {
         ArgsForMinimaxThread* args = new ArgsForMinimaxThread(
-                id,
+                *it,
                 possibleAnswers,
-                chunksToEvaluate[id],
-                guessesAlreadyMade,
-                bestGuessFromEachThread,
-                writeLock);
+                answerTrie,
+                chunksToEvaluate[*it],
+                &history,
+                &bestGuessFromEachChunk,
+                options._isCancelled,
+                scoringPolicy,
+                isNumaAware);
         argsForMinimaxThreads.push_back(args);
-        minimaxThreads.push_back(thread(getBestGuessFromSubset, args));
+    }
+
+    // Chunks are dealt round-robin to the threads, one thread each by default.
+    int numThreads = options._numThreads > 0 && options._numThreads < NUM_THREADS ?
+            options._numThreads : NUM_THREADS;
+    numThreads = std::min(numThreads, int(argsForMinimaxThreads.size()));
+    for (int id = 0; id < numThreads; ++id) {
+        minimaxThreads.push_back(thread(evaluateChunksOnThread,
+                                        &argsForMinimaxThreads,
+                                        id,
+                                        numThreads,
+                                        isNumaAware));
     }
 
     // Wait for all threads to finish up.
@@ -239,76 +801,440 @@ Pm getNextGuessUsingMinimax(const PmSet* possibleAnswers, const PmSet* guessesAl
         it->join();
     }
 
-    // Find the best guess in the set bestGuessFromEachThread.
+    // Find the best guess of all the chunks. Among equal scores a remaining
+    // answer wins, then the first in guess order, since chunks are consecutive
+    // runs of candidates and are reduced in chunk order.
     Pm bestGuess("");
-    long numRemainingAfterBestGuess = possibleAnswers->size();
-    for (map<Pm, int>::const_iterator it = bestGuessFromEachThread->begin();
-         it != bestGuessFromEachThread->end();
+    long bestScore = getUnsplitScore(scoringPolicy, long(possibleAnswers->size()));
+    bool isBestAnswer = false;
+    for (vector<pair<Pm, long> >::const_iterator it = bestGuessFromEachChunk.begin();
+         it != bestGuessFromEachChunk.end();
          ++it) {
-        Pm guess = it->first;
-        int numRemainingAfterGuess = it->second;
-
-        if (numRemainingAfterGuess < numRemainingAfterBestGuess) {
-            bestGuess = guess;
-            numRemainingAfterBestGuess = numRemainingAfterGuess;
+        if (it->second > bestScore || (it->second == bestScore && isBestAnswer)) {
+            continue;
+        }
+        bool isAnswer = possibleAnswers->contains(it->first);
+        if (isBetterGuess(it->second, isAnswer, bestScore, isBestAnswer)) {
+            bestGuess = it->first;
+            bestScore = it->second;
+            isBestAnswer = isAnswer;
         }
     }
 
-    // Clean up allocated args, chunks, map, and mutex.
+    // Clean up allocated args, trie and chunks.
     for (vector<ArgsForMinimaxThread*>::iterator it = argsForMinimaxThreads.begin();
          it != argsForMinimaxThreads.end();
          ++it) {
         delete *it;
     }
-    for (int i = 0; i < NUM_THREADS; ++i) {
+    delete answerTrie;
+    for (int i = 0; i < numChunks; ++i) {
         if (chunksToEvaluate && chunksToEvaluate[i]) {
             delete chunksToEvaluate[i];
         }
     }
     if (chunksToEvaluate) {
-        delete chunksToEvaluate;
+        delete[] chunksToEvaluate;
     }
-    delete bestGuessFromEachThread;
-    delete writeLock;
 
     return bestGuess;
 }
 
+// Stage of minimax for a number of remaining answers.
+static MinimaxStage getMinimaxStageForSize(size_t numAnswers, const MinimaxCostModel* costModel)
+{
+    if (costModel) {
+        return costModel->chooseStage(numAnswers, getFixedPool()->size());
+    }
+    if (numAnswers > START_PART_MM) {
+        return POOL_MINIMAX;
+    } else if (numAnswers > START_FULL_MM) {
+        return PARTIAL_MINIMAX;
+    }
+    return FULL_MINIMAX;
+}
+
+MinimaxStage getMinimaxStage(const PmSet* possibleAnswers, const MinimaxCostModel* costModel)
+{
+    return getMinimaxStageForSize(possibleAnswers->size(), costModel);
+}
+
+// Best guess on each side of each expanded Truth Booth, over one chunk of
+// candidates. Scores start at the side's size and guesses empty, so that a
+// side nothing splits is left for the caller.
+struct LookaheadChunk {
+    const PmSet* _candidates;
+    ScoringPolicy _scoringPolicy;
+    vector<long> _bestScoreIfMatch;
+    vector<long> _bestScoreIfNoMatch;
+    vector<Pm> _bestGuessIfMatch;
+    vector<Pm> _bestGuessIfNoMatch;
+    vector<bool> _isBestAnswerIfMatch;
+    vector<bool> _isBestAnswerIfNoMatch;
+};
+
+// Score the candidates of every stride-th chunk, starting at first, against
+// every expanded booth at once. The histogram of each booth's yes side is
+// counted on that side's trie, and the no side is what is left of the
+// histogram of all answers. The tries are shared by every thread.
+static void evaluateLookaheadChunks(const AnswerTrie* possibleAnswers,
+                                    const vector<AnswerTrie*>* answersIfMatch,
+                                    const GuessHistory* guessesAlreadyMade,
+                                    vector<LookaheadChunk>* chunks,
+                                    int first,
+                                    int stride)
+{
+    for (size_t c = size_t(first); c < chunks->size(); c += size_t(stride)) {
+        LookaheadChunk& chunk = (*chunks)[c];
+        size_t numBooths = chunk._bestScoreIfMatch.size();
+
+        for (PmSet::const_iterator guess = chunk._candidates->begin();
+             guess != chunk._candidates->end();
+             ++guess) {
+            if (guessesAlreadyMade->contains(guess.rank())) {
+                continue;
+            }
+            int numGivenResponse[PERM_LENGTH + 1];
+            possibleAnswers->countResponses(*guess, numGivenResponse);
+
+            for (size_t booth = 0; booth < numBooths; ++booth) {
+                int ifMatch[PERM_LENGTH + 1];
+                (*answersIfMatch)[booth]->countResponses(*guess, ifMatch);
+                int ifNoMatch[PERM_LENGTH + 1];
+                for (int r = 0; r <= PERM_LENGTH; ++r) {
+                    ifNoMatch[r] = numGivenResponse[r] - ifMatch[r];
+                }
+                long scoreIfMatch = scoreHistogram(chunk._scoringPolicy, ifMatch);
+                long scoreIfNoMatch = scoreHistogram(chunk._scoringPolicy, ifNoMatch);
+                bool isAnswerIfMatch = ifMatch[PERM_LENGTH] > 0;
+                bool isAnswerIfNoMatch = ifNoMatch[PERM_LENGTH] > 0;
+                if (isBetterGuess(scoreIfMatch, isAnswerIfMatch,
+                                  chunk._bestScoreIfMatch[booth],
+                                  chunk._isBestAnswerIfMatch[booth])) {
+                    chunk._bestScoreIfMatch[booth] = scoreIfMatch;
+                    chunk._bestGuessIfMatch[booth] = *guess;
+                    chunk._isBestAnswerIfMatch[booth] = isAnswerIfMatch;
+                }
+                if (isBetterGuess(scoreIfNoMatch, isAnswerIfNoMatch,
+                                  chunk._bestScoreIfNoMatch[booth],
+                                  chunk._isBestAnswerIfNoMatch[booth])) {
+                    chunk._bestScoreIfNoMatch[booth] = scoreIfNoMatch;
+                    chunk._bestGuessIfNoMatch[booth] = *guess;
+                    chunk._isBestAnswerIfNoMatch[booth] = isAnswerIfNoMatch;
+                }
+            }
+        }
+    }
+}
+
+// Fold one chunk's best guess for one side of a booth into the best so far,
+// ties going to a remaining answer and then the earlier chunk, as in the
+// reduction of plain minimax. An empty guess means nothing in the chunk
+// split the side.
+static void mergeLookaheadSide(long score,
+                               const Pm& guess,
+                               bool isAnswer,
+                               long* bestScore,
+                               Pm* bestGuess,
+                               bool* isBestAnswer)
+{
+    if (guess.empty()) {
+        return;
+    }
+    if (isBetterGuess(score, isAnswer, *bestScore, *isBestAnswer)) {
+        *bestScore = score;
+        *bestGuess = guess;
+        *isBestAnswer = isAnswer;
+    }
+}
+
+// Perfect Matching for one side of the chosen booth: the only answer left,
+// the best guess found, or plain minimax on that side if nothing split it.
+// That last case needs every candidate of the larger side's stage to leave
+// the side unsplit, so it is rare, and costs at most the minimax pass a week
+// without lookahead would make for the side; it is left uncapped so the
+// guess is never worse than that week's.
+static Pm getLookaheadGuessForSide(const PmSet* possibleAnswers,
+                                   const Tb& truthBooth,
+                                   bool isMatch,
+                                   const Pm& bestGuess,
+                                   const PmSet* guessesAlreadyMade,
+                                   const MinimaxOptions& options)
+{
+    PmSet side(possibleAnswers->begin(), possibleAnswers->end());
+    side.filter(truthBooth, isMatch);
+    if (side.size() == 1) {
+        return side.get(0);
+    }
+    if (!bestGuess.empty() || side.size() == 0) {
+        return bestGuess;
+    }
+    return getNextPerfectMatchingGuess(&side, guessesAlreadyMade, options);
+}
+
+LookaheadGuesses getNextGuessesUsingLookahead(const PmSet* possibleAnswers,
+                                              const TbSet* tbGuessesAlreadyMade,
+                                              const PmSet* pmGuessesAlreadyMade,
+                                              int numTruthBooths,
+                                              const MinimaxOptions& options)
+{
+    LookaheadGuesses guesses;
+
+    // Rank booths the way getNextTruthBoothGuess does, closest to half first.
+    long numOccurrencesOfMatch[PERM_LENGTH][PERM_LENGTH] = {{0}};
+    for (PmSet::const_iterator it = possibleAnswers->begin(); it != possibleAnswers->end(); ++it) {
+        for (int i = 0; i < PERM_LENGTH; ++i) {
+            ++numOccurrencesOfMatch[i][(*it)[i] - '0'];
+        }
+    }
+    long numAnswers = long(possibleAnswers->size());
+    vector<pair<long, Tb> > rankedBooths;
+    for (int i = 0; i < PERM_LENGTH; ++i) {
+        for (int c = 0; c < PERM_LENGTH; ++c) {
+            Tb truthBooth(i, char('0' + c));
+            long numMatches = numOccurrencesOfMatch[i][c];
+            if (numMatches > 0 && numMatches < numAnswers &&
+                    !tbGuessesAlreadyMade->contains(truthBooth)) {
+                rankedBooths.push_back(pair<long, Tb>(abs(numAnswers - 2 * numMatches), truthBooth));
+            }
+        }
+    }
+    if (rankedBooths.empty()) {
+        // No booth left tells the answers apart, so the week is one guess.
+        guesses._truthBooth = getNextTruthBoothGuess(possibleAnswers, tbGuessesAlreadyMade);
+        guesses._perfectMatchingIfMatch = getNextPerfectMatchingGuess(possibleAnswers,
+                                                                      pmGuessesAlreadyMade,
+                                                                      options);
+        guesses._perfectMatchingIfNoMatch = guesses._perfectMatchingIfMatch;
+        return guesses;
+    }
+    sort(rankedBooths.begin(), rankedBooths.end());
+    if (rankedBooths.size() > size_t(numTruthBooths)) {
+        rankedBooths.resize(size_t(numTruthBooths));
+    }
+
+    // One trie of all answers and one of each expanded booth's yes side.
+    vector<AnswerTrie*> answersIfMatch;
+    long largestSide = 0;
+    for (size_t booth = 0; booth < rankedBooths.size(); ++booth) {
+        const Tb& truthBooth = rankedBooths[booth].second;
+        long numMatches = numOccurrencesOfMatch[truthBooth.index][truthBooth.charAtIndex - '0'];
+        PmSet side(possibleAnswers->begin(), possibleAnswers->end());
+        side.filter(truthBooth, true);
+        answersIfMatch.push_back(new AnswerTrie(&side));
+        largestSide = std::max(largestSide, std::max(numMatches, numAnswers - numMatches));
+    }
+    const AnswerTrie answers(possibleAnswers);
+
+    // Candidates are those minimax would use on the larger side of a booth,
+    // scored against all answers, so that one pass serves both sides.
+    MinimaxStage stage = getMinimaxStageForSize(size_t(largestSide), options._costModel);
+    ScoringPolicy scoringPolicy = options._scoringPolicies._forStage[stage];
+    PmSet candidateStorage;
+    const PmSet* candidates = getCandidatesForStage(stage, possibleAnswers, &candidateStorage);
+    PmSet** chunksToEvaluate = candidates->copyIntoChunks(NUM_THREADS);
+    vector<LookaheadChunk> chunks(NUM_THREADS);
+    for (int id = 0; id < NUM_THREADS; ++id) {
+        chunks[id]._candidates = chunksToEvaluate[id];
+        chunks[id]._scoringPolicy = scoringPolicy;
+        for (size_t booth = 0; booth < rankedBooths.size(); ++booth) {
+            const Tb& truthBooth = rankedBooths[booth].second;
+            long numMatches = numOccurrencesOfMatch[truthBooth.index][truthBooth.charAtIndex - '0'];
+            chunks[id]._bestScoreIfMatch.push_back(getUnsplitScore(scoringPolicy, numMatches));
+            chunks[id]._bestScoreIfNoMatch.push_back(
+                    getUnsplitScore(scoringPolicy, numAnswers - numMatches));
+        }
+        chunks[id]._bestGuessIfMatch.resize(rankedBooths.size());
+        chunks[id]._bestGuessIfNoMatch.resize(rankedBooths.size());
+        chunks[id]._isBestAnswerIfMatch.resize(rankedBooths.size());
+        chunks[id]._isBestAnswerIfNoMatch.resize(rankedBooths.size());
+    }
+
+    const GuessHistory history(pmGuessesAlreadyMade);
+    int numThreads = options._numThreads > 0 && options._numThreads < NUM_THREADS ?
+            options._numThreads : NUM_THREADS;
+    vector<thread> lookaheadThreads;
+    for (int id = 0; id < numThreads; ++id) {
+        lookaheadThreads.push_back(thread(evaluateLookaheadChunks,
+                                          &answers,
+                                          &answersIfMatch,
+                                          &history,
+                                          &chunks,
+                                          id,
+                                          numThreads));
+    }
+    for (vector<thread>::iterator it = lookaheadThreads.begin(); it != lookaheadThreads.end(); ++it) {
+        it->join();
+    }
+
+    // Combine chunks as minimax does, ties going to a remaining answer and
+    // then the earlier chunk. Then take the booth whose sides score best
+    // together, ties going to the more even.
+    size_t bestBooth = 0;
+    long bestScore = LONG_MAX;
+    Pm bestGuessIfMatch;
+    Pm bestGuessIfNoMatch;
+    for (size_t booth = 0; booth < rankedBooths.size(); ++booth) {
+        long scoreIfMatch = chunks[0]._bestScoreIfMatch[booth];
+        long scoreIfNoMatch = chunks[0]._bestScoreIfNoMatch[booth];
+        Pm guessIfMatch = chunks[0]._bestGuessIfMatch[booth];
+        Pm guessIfNoMatch = chunks[0]._bestGuessIfNoMatch[booth];
+        bool isAnswerIfMatch = chunks[0]._isBestAnswerIfMatch[booth];
+        bool isAnswerIfNoMatch = chunks[0]._isBestAnswerIfNoMatch[booth];
+        for (int id = 1; id < NUM_THREADS; ++id) {
+            const LookaheadChunk& chunk = chunks[id];
+            mergeLookaheadSide(chunk._bestScoreIfMatch[booth],
+                               chunk._bestGuessIfMatch[booth],
+                               chunk._isBestAnswerIfMatch[booth],
+                               &scoreIfMatch,
+                               &guessIfMatch,
+                               &isAnswerIfMatch);
+            mergeLookaheadSide(chunk._bestScoreIfNoMatch[booth],
+                               chunk._bestGuessIfNoMatch[booth],
+                               chunk._isBestAnswerIfNoMatch[booth],
+                               &scoreIfNoMatch,
+                               &guessIfNoMatch,
+                               &isAnswerIfNoMatch);
+        }
+        long score = combineScores(scoringPolicy, scoreIfMatch, scoreIfNoMatch);
+        if (score < bestScore) {
+            bestBooth = booth;
+            bestScore = score;
+            bestGuessIfMatch = guessIfMatch;
+            bestGuessIfNoMatch = guessIfNoMatch;
+        }
+    }
+
+    for (int i = 0; i < NUM_THREADS; ++i) {
+        delete chunksToEvaluate[i];
+    }
+    delete[] chunksToEvaluate;
+    for (vector<AnswerTrie*>::iterator it = answersIfMatch.begin(); it != answersIfMatch.end(); ++it) {
+        delete *it;
+    }
+
+    guesses._truthBooth = rankedBooths[bestBooth].second;
+    guesses._perfectMatchingIfMatch = getLookaheadGuessForSide(possibleAnswers,
+                                                               guesses._truthBooth,
+                                                               true,
+                                                               bestGuessIfMatch,
+                                                               pmGuessesAlreadyMade,
+                                                               options);
+    guesses._perfectMatchingIfNoMatch = getLookaheadGuessForSide(possibleAnswers,
+                                                                 guesses._truthBooth,
+                                                                 false,
+                                                                 bestGuessIfNoMatch,
+                                                                 pmGuessesAlreadyMade,
+                                                                 options);
+    return guesses;
+}
+
+const PmSet* getFixedPool()
+{
+    // Read once, then shared read-only by every game and thread.
+    static const PmSet* fixedPool = []() {
+        PmSet* pool = new PmSet();
+        pool->populateFromFile(fixedPoolFilename);
+        isFixedPoolRead = true;
+        return pool;
+    }();
+    return fixedPool;
+}
+
+bool setFixedPoolFilename(const string& filename)
+{
+    if (isFixedPoolRead) {
+        return filename == fixedPoolFilename;
+    }
+    fixedPoolFilename = filename;
+    return true;
+}
+
+void getBestGuessesFromHistograms(const MinimaxHistograms* histograms,
+                                  PmSet** chunks,
+                                  int numChunks,
+                                  const GuessHistory* guessesAlreadyMade,
+                                  long numPossibleAnswers,
+                                  ScoringPolicy scoringPolicy,
+                                  vector<pair<Pm, long> >* bestGuesses)
+{
+    // Same choice as getBestGuessFromSubset makes for each chunk, with the
+    // histograms already counted. Chunks are consecutive runs of candidates.
+    const PerfectMatchingUniverse& universe = PerfectMatchingUniverse::get();
+    size_t i = 0;
+    for (int id = 0; id < numChunks; ++id) {
+        Pm bestGuess = DIGITS;
+        long bestScore = getUnsplitScore(scoringPolicy, numPossibleAnswers);
+        bool isBestAnswer = false;
+
+        for (size_t end = i + chunks[id]->size(); i < end; ++i) {
+            PmRank candidate = histograms->getCandidate(i);
+            if (!guessesAlreadyMade->contains(candidate)) {
+                const int* numRemainingGivenResponse = histograms->getHistogram(i);
+                long score = scoreHistogram(scoringPolicy, numRemainingGivenResponse);
+                bool isAnswer = numRemainingGivenResponse[PERM_LENGTH] > 0;
+                if (isBetterGuess(score, isAnswer, bestScore, isBestAnswer)) {
+                    bestGuess = universe.at(candidate);
+                    bestScore = score;
+                    isBestAnswer = isAnswer;
+                }
+            }
+        }
+
+        (*bestGuesses)[id] = pair<Pm, long>(bestGuess, bestScore);
+    }
+}
+
 void getBestGuessFromSubset(const ArgsForMinimaxThread *args)
 {
     // Find the query in possibleGuesses which eliminates the most possible answers.
     Pm bestGuess = DIGITS;
-    long numRemainingAfterBestGuess = args->_possibleAnswers->size();
+    long bestScore = getUnsplitScore(args->_scoringPolicy, long(args->_possibleAnswers->size()));
+    bool isBestAnswer = false;
 
-    for (PmSet::const_iterator possibleGuess = args->_possibleGuesses->begin();
-         possibleGuess != args->_possibleGuesses->end();
-         ++possibleGuess) {
-        Pm guess = *possibleGuess;
+    // Survivors are scattered across the universe, so candidates are counted
+    // against the trie of them, which shares the work of common prefixes.
+    // When node-local, the chunk is first touched by this thread as well,
+    // packed into one word per candidate.
+    const AnswerTrie* possibleAnswers = args->_answerTrie;
+    vector<PackedPerfectMatching> localGuesses;
+    Pm localGuess;
+    if (args->_isNodeLocal) {
+        localGuesses.reserve(args->_possibleGuesses->size());
+        for (PmSet::const_iterator it = args->_possibleGuesses->begin();
+             it != args->_possibleGuesses->end();
+             ++it) {
+            localGuesses.push_back(packPerfectMatching(*it));
+        }
+    }
 
-        if (!args->_guessesAlreadyMade->contains(guess)) {
-            vector<int> numRemainingGivenResponse(PERM_LENGTH + 1, 0);
+    PmSet::const_iterator possibleGuess = args->_possibleGuesses->begin();
+    for (size_t g = 0; g < args->_possibleGuesses->size(); ++g, ++possibleGuess) {
+        if (args->_isCancelled && *args->_isCancelled) {
+            break;
+        }
+        if (!args->_guessesAlreadyMade->contains(possibleGuess.rank())) {
+            if (args->_isNodeLocal) {
+                localGuess = unpackPerfectMatching(localGuesses[g]);
+            }
+            const Pm& guess = args->_isNodeLocal ? localGuess : *possibleGuess;
             // Check how many possibilities would remain after guessing guess
-            for (PmSet::const_iterator it = args->_possibleAnswers->begin();
-                 it != args->_possibleAnswers->end();
-                 ++it) {
-                numRemainingGivenResponse[numInCommon(guess, *it)] += 1;
-            }
-            // Find the # remaining in the worst-case scenario.
-            int numRemainingAfterWorstResponse =
-                    *max_element(numRemainingGivenResponse.begin(),
-                                 numRemainingGivenResponse.end());
-            // If this is lowest worst-case #remaining, set low water mark.
-            if (numRemainingAfterWorstResponse < numRemainingAfterBestGuess) {
+            int numRemainingGivenResponse[PERM_LENGTH + 1];
+            possibleAnswers->countResponses(guess, numRemainingGivenResponse);
+            // Score the split, e.g., the # remaining in the worst-case scenario.
+            long score = scoreHistogram(args->_scoringPolicy, numRemainingGivenResponse);
+            bool isAnswer = numRemainingGivenResponse[PERM_LENGTH] > 0;
+            // If this is the best score so far, set low water mark.
+            if (isBetterGuess(score, isAnswer, bestScore, isBestAnswer)) {
                 bestGuess = guess;
-                numRemainingAfterBestGuess = numRemainingAfterWorstResponse;
+                bestScore = score;
+                isBestAnswer = isAnswer;
             }
         }
     }
 
-    // After finding best guess in the chunk, write result to the shared dictionary.
-    args->_writeLock->lock();
-    args->_bestGuesses->insert(pair<Pm, int>(bestGuess, numRemainingAfterBestGuess));
-    args->_writeLock->unlock();
+    // After finding best guess in the chunk, write result to this chunk's slot.
+    (*args->_bestGuesses)[args->_threadId] = pair<Pm, long>(bestGuess, bestScore);
 
     return;
 }
@@ -316,140 +1242,275 @@ void getBestGuessFromSubset(const ArgsForMinimaxThread *args)
 string getPrintableNames(const PerfectMatching& p,
                          const map<int, string>* femaleNames,
                          const map<char, string>* maleNames) {
-    stringstream printableNamesBuilder;
+    string printableNames;
 
     int i = 0;
     for (PerfectMatching::const_iterator it = p.begin(); it != p.end(); it++) {
-        printableNamesBuilder << "    " <<  femaleNames->at(i++)
-                              << " + " << maleNames->at(*it);
+        printableNames += "    ";
+        printableNames += femaleNames->at(i++);
+        printableNames += " + ";
+        printableNames += maleNames->at(*it);
         if (it != p.end() - 1)
-            printableNamesBuilder << endl;
+            printableNames += '\n';
     }
 
-    return printableNamesBuilder.str();
+    return printableNames;
 }
 
 string getPrintableNames(const TruthBooth& truthBooth,
                          const map<int, string>* femaleNames,
                          const map<char, string>* maleNames) {
-    stringstream printableNamesBuilder;
+    string printableNames = "(";
+    printableNames += femaleNames->at(truthBooth.index);
+    printableNames += ", ";
+    printableNames += maleNames->at(truthBooth.charAtIndex);
+    printableNames += ")";
 
-    printableNamesBuilder << "(" << femaleNames->at(truthBooth.index) << ", "
-                          << maleNames->at(truthBooth.charAtIndex) << ")";
-
-    return printableNamesBuilder.str();
+    return printableNames;
 }
 
 string getPrintableNumbers(const PerfectMatching& p) {
-    stringstream printableNumbersBuilder;
-
-    printableNumbersBuilder << "(";
+    string printableNumbers = "(";
     for (PerfectMatching::const_iterator i = p.begin(); i != p.end(); i++) {
-        printableNumbersBuilder << *i;
+        printableNumbers += *i;
         if (i != p.end() - 1)
-            printableNumbersBuilder << ", ";
+            printableNumbers += ", ";
     }
-    printableNumbersBuilder << ")";
+    printableNumbers += ")";
 
-    return printableNumbersBuilder.str();
+    return printableNumbers;
 }
 
-void runAreYouTheOne(const Pm& answer, const AytoSettings* settings)
+void printAnswer(ostream& out, const Pm& answer, const AytoSettings* settings)
 {
-    TbSet* tbGuessesAlreadyMade = new TbSet(); // Queries submitted in truth booth.
-    PmSet* pmGuessesAlreadyMade = new PmSet(); // Queries submitted in perfect matching.
-    PmSet* possibleAnswers = new PmSet();      // Remaining possibilities for answer.
-    possibleAnswers->populateAll();
+    if (settings->_isPrintNumbersMode) {
+        out << "Answer: " << getPrintableNumbers(answer) << '\n';
+    } else {
+        out << "Answer:\n"
+            << getPrintableNames(answer, settings->_femaleNames, settings->_maleNames)
+            << '\n';
+    }
+}
+
+void printTruthBoothFeedback(ostream& out, const WeekRecord& week, const AytoSettings* settings)
+{
+    out << "  * Truth Booth: ";
+    if (settings->_isPrintNumbersMode) {
+        out << getPrintableNumbers(week._truthBooth.toString()) << '\n';
+    } else {
+        out << getPrintableNames(week._truthBooth,
+                                 settings->_femaleNames,
+                                 settings->_maleNames)
+            << '\n';
+    }
+    out << "  > Feedback: " << (week._isMatch ? "Yes" : "No") << '\n';
+    out << "    Now " << week._numRemainingAfterTb << " remaining.\n";
+}
+
+void printPerfectMatchingFeedback(ostream& out, const WeekRecord& week, const AytoSettings* settings)
+{
+    out << "  * Perfect Matching: ";
+    if (settings->_isPrintNumbersMode) {
+        out << getPrintableNumbers(week._perfectMatching) << '\n';
+    } else {
+        out << '\n' << getPrintableNames(week._perfectMatching,
+                                         settings->_femaleNames,
+                                         settings->_maleNames)
+            << '\n';
+    }
+    out << "  > Feedback: " << week._numCorrect << " correct\n";
+    out << "    Now " << week._numRemainingAfterPm << " remaining.\n";
+}
 
-    if (!settings->_isInteractiveMode) {
+void printResults(ostream& out, const GameRecord& record, const AytoSettings* settings)
+{
+    // Print a summary of the game, the guesses made in each week.
+    out << "Results:\n";
+    int intWidth = (record._weeks.size() < 10 ? 1 : 2);
+    for (unsigned int i = 0; i < record._weeks.size(); ++i) {
+        const WeekRecord& week = record._weeks[i];
+        out << "[Week " << setw(intWidth) << (i + 1) << "] ";
         if (settings->_isPrintNumbersMode) {
-            cout << "Answer: " << getPrintableNumbers(answer) << endl;
+            out << getPrintableNumbers(week._truthBooth.toString())
+                << ", "
+                << getPrintableNumbers(week._perfectMatching)
+                << '\n';
         } else {
-            cout << "Answer:" << endl
-                 << getPrintableNames(answer, settings->_femaleNames, settings->_maleNames)
-                 << endl;
+            out << getPrintableNames(week._truthBooth,
+                                     settings->_femaleNames,
+                                     settings->_maleNames)
+                << '\n'
+                << getPrintableNames(week._perfectMatching,
+                                     settings->_femaleNames,
+                                     settings->_maleNames)
+                << '\n';
+        }
+    }
+}
+
+void printTranscript(ostream& out, const GameRecord& record, const AytoSettings* settings)
+{
+    printAnswer(out, record._answer, settings);
+    for (unsigned int i = 0; i < record._weeks.size(); ++i) {
+        out << "End of Week " << (i + 1) << '\n';
+        if (settings->_isVerboseMode) {
+            printTruthBoothFeedback(out, record._weeks[i], settings);
+            printPerfectMatchingFeedback(out, record._weeks[i], settings);
         }
     }
+    printResults(out, record, settings);
+}
+
+int runAreYouTheOne(const Pm& answer, const AytoSettings* settings)
+{
+    // Survivors of each game are carved out of this thread's scratch arena,
+    // which is recycled rather than freed between games.
+    static thread_local ScratchArena scratchForGame(SCRATCH_BLOCK_SIZE);
+    scratchForGame.reset();
+
+    TbSet* tbGuessesAlreadyMade = new TbSet(); // Queries submitted in truth booth.
+    PmSet* pmGuessesAlreadyMade = new PmSet(); // Queries submitted in perfect matching.
+    PmSet* possibleAnswers = new PmSet(&scratchForGame); // Remaining possibilities.
+    possibleAnswers->populateAll();                      // View of the universe.
+    GameRecord record;                                   // Everything printed below.
+    record._answer = answer;
+    MinimaxHistograms* histograms = settings->_isIncrementalMode ?
+            new MinimaxHistograms(NUM_THREADS) : nullptr;        // Kept across weeks.
+    GuessSpeculator* speculator = settings->_isInteractiveMode ?
+            new GuessSpeculator(settings->_costModel,
+                                settings->_scoringPolicies,
+                                settings->_decisionTree,
+                                settings->_numLookaheadBooths > 0) : nullptr; // Busy while we wait.
+    MinimaxOptions minimaxOptions;
+    minimaxOptions._coordinator = settings->_minimaxCoordinator;
+    minimaxOptions._histograms = histograms;
+    minimaxOptions._costModel = settings->_costModel;
+    minimaxOptions._scoringPolicies = settings->_scoringPolicies;
+    minimaxOptions._isNumaAware = settings->_isNumaMode;
+    minimaxOptions._numThreads = settings->_numMinimaxThreads;
+
+    // Quiet games only produce a compact record once they are over.
+    bool isLive = settings->_isInteractiveMode ||
+            (!settings->_resultWriter && settings->_numSamples == 0);
+
+    if (isLive && !settings->_isInteractiveMode) {
+        printAnswer(cout, answer, settings);
+    }
 
     while (true) {
+        WeekRecord week;
+
         // Submit a single Tb to the Truth Booth.
-        cout << "End of Week " << (tbGuessesAlreadyMade->size() + 1) << endl;
-        Tb nextTbGuess = getNextTruthBoothGuess(possibleAnswers, tbGuessesAlreadyMade);
-        tbGuessesAlreadyMade->add(nextTbGuess);
-        bool isPairCorrect;
+        if (isLive) {
+            cout << "End of Week " << (tbGuessesAlreadyMade->size() + 1) << '\n';
+        }
+        // From week 3, lookahead picks the booth and both guesses after it.
+        bool isTbInTree = settings->_decisionTree &&
+                settings->_decisionTree->findTruthBooth(possibleAnswers, &week._truthBooth);
+        bool isLookahead = !isTbInTree && settings->_numLookaheadBooths > 0 &&
+                pmGuessesAlreadyMade->size() > 1 && possibleAnswers->size() > 1;
+        LookaheadGuesses lookahead;
+        if (isLookahead) {
+            lookahead = getNextGuessesUsingLookahead(possibleAnswers,
+                                                     tbGuessesAlreadyMade,
+                                                     pmGuessesAlreadyMade,
+                                                     settings->_numLookaheadBooths,
+                                                     minimaxOptions);
+            week._truthBooth = lookahead._truthBooth;
+        } else if (!isTbInTree) {
+            week._truthBooth = getNextTruthBoothGuess(possibleAnswers, tbGuessesAlreadyMade);
+        }
+        tbGuessesAlreadyMade->add(week._truthBooth);
         if (settings->_isInteractiveMode) {
+            if (!isLookahead) {
+                speculator->speculateTruthBooth(possibleAnswers,
+                                                week._truthBooth,
+                                                pmGuessesAlreadyMade);
+            }
             string userInput;
             do {
                 if (settings->_isPrintNumbersMode) {
-                    cout << "Question: Is there a '" << nextTbGuess.charAtIndex
-                         << "' in position " << nextTbGuess.index
+                    cout << "Question: Is there a '" << week._truthBooth.charAtIndex
+                         << "' in position " << week._truthBooth.index
                          << " (indexed starting with 0)? [yes/no]" << endl;
                 } else {
-                    cout << "Question: Are " << settings->_femaleNames->at(nextTbGuess.index)
-                         << " and " << settings->_maleNames->at(nextTbGuess.charAtIndex)
+                    cout << "Question: Are " << settings->_femaleNames->at(week._truthBooth.index)
+                         << " and " << settings->_maleNames->at(week._truthBooth.charAtIndex)
                          << " matched together? [yes/no]" << endl;
                 }
                 cin >> userInput;
-                isPairCorrect = userInput[0] == 'y' || userInput[0] == 'Y';
+                week._isMatch = userInput[0] == 'y' || userInput[0] == 'Y';
             } while (userInput[0] != 'y' && userInput[0] != 'n' &&
                      userInput[0] != 'Y' && userInput[0] != 'N');
         } else {
-            isPairCorrect = nextTbGuess.isContainedIn(answer);
+            week._isMatch = week._truthBooth.isContainedIn(answer);
         }
-        possibleAnswers->filter(nextTbGuess, isPairCorrect);
-        if (settings->_isVerboseMode) {
-            cout << "  * Truth Booth: " << flush;
-            if (settings->_isPrintNumbersMode) {
-                cout << getPrintableNumbers(nextTbGuess.toString()) << endl;
-            } else {
-                cout << getPrintableNames(nextTbGuess,
-                                          settings->_femaleNames,
-                                          settings->_maleNames)
-                     << endl;
-            }
-            cout << "  > Feedback: " << (isPairCorrect ? "Yes" : "No") << endl;
-            cout << "    Now " << possibleAnswers->size() << " remaining." << endl;
+        possibleAnswers->filter(week._truthBooth, week._isMatch);
+        week._numRemainingAfterTb = possibleAnswers->size();
+        if (speculator) {
+            speculator->discardUnreachable(possibleAnswers);
+        }
+        if (isLive && settings->_isVerboseMode) {
+            printTruthBoothFeedback(cout, week, settings);
         }
 
         // Submit a full PM as the Perfect Matching.
-        Pm nextPmGuess = getNextPerfectMatchingGuess(possibleAnswers, pmGuessesAlreadyMade);
-        pmGuessesAlreadyMade->add(nextPmGuess);
-        int numCorrect;
+        // A tree move or lookahead's guess, if any, comes before minimax.
+        bool isPmChosen = settings->_decisionTree &&
+                settings->_decisionTree->findPerfectMatching(possibleAnswers,
+                                                             &week._perfectMatching);
+        if (!isPmChosen && isLookahead) {
+            week._perfectMatching = week._isMatch ?
+                    lookahead._perfectMatchingIfMatch : lookahead._perfectMatchingIfNoMatch;
+            isPmChosen = !week._perfectMatching.empty();
+        }
+        if (isLive && !isPmChosen && possibleAnswers->size() > 1 && pmGuessesAlreadyMade->size() > 1 &&
+                getMinimaxStage(possibleAnswers, settings->_costModel) == FULL_MINIMAX &&
+                !(speculator && speculator->isReady(possibleAnswers, pmGuessesAlreadyMade))) {
+            cout << "    Full minimax... May take up to one minute." << endl;
+        }
+        if (!isPmChosen && (!speculator || !speculator->takeGuess(possibleAnswers,
+                                                                pmGuessesAlreadyMade,
+                                                                &week._perfectMatching))) {
+            week._perfectMatching = getNextPerfectMatchingGuess(possibleAnswers,
+                                                                pmGuessesAlreadyMade,
+                                                                minimaxOptions);
+        }
+        pmGuessesAlreadyMade->add(week._perfectMatching);
         if (settings->_isInteractiveMode) {
+            speculator->speculatePerfectMatching(possibleAnswers,
+                                                 week._perfectMatching,
+                                                 tbGuessesAlreadyMade,
+                                                 pmGuessesAlreadyMade);
             do {
                 if (settings->_isPrintNumbersMode) {
                     cout << "Question: How many of the following "
                          << "are in the correct spot?" << endl;
-                    cout << getPrintableNumbers(nextPmGuess) << endl;
+                    cout << getPrintableNumbers(week._perfectMatching) << endl;
                 } else {
                     cout << "Question: How many of the following "
                          << "matches are correct?" << endl;
-                    cout << getPrintableNames(nextPmGuess,
+                    cout << getPrintableNames(week._perfectMatching,
                                               settings->_femaleNames,
                                               settings->_maleNames)
                          << endl;
                 }
-                cin >> numCorrect;
-            } while (numCorrect < 0 || numCorrect > PERM_LENGTH);
+                cin >> week._numCorrect;
+            } while (week._numCorrect < 0 || week._numCorrect > PERM_LENGTH);
         } else {
-            numCorrect = numInCommon(nextPmGuess, answer);
+            week._numCorrect = numInCommon(week._perfectMatching, answer);
         }
 
-        possibleAnswers->filter(nextPmGuess, numCorrect);
-        if (settings->_isVerboseMode) {
-            cout << "  * Perfect Matching: " << flush;
-            if (settings->_isPrintNumbersMode) {
-                cout << getPrintableNumbers(nextPmGuess) << endl;
-            } else {
-                cout << endl << getPrintableNames(nextPmGuess,
-                                                  settings->_femaleNames,
-                                                  settings->_maleNames)
-                     << endl;
-            }
-            cout << "  > Feedback: " << numCorrect << " correct" << endl;
-            cout << "    Now " << possibleAnswers->size() << " remaining." << endl;
+        possibleAnswers->filter(week._perfectMatching, week._numCorrect);
+        week._numRemainingAfterPm = possibleAnswers->size();
+        if (speculator) {
+            speculator->discardUnreachable(possibleAnswers);
+        }
+        if (isLive && settings->_isVerboseMode) {
+            printPerfectMatchingFeedback(cout, week, settings);
         }
-        if (numCorrect == PERM_LENGTH) {
+        record._weeks.push_back(week);
+        if (week._numCorrect == PERM_LENGTH) {
             break;
         }
         if (settings->_isInteractiveMode && possibleAnswers->size() == 0) {
@@ -459,38 +1520,38 @@ void runAreYouTheOne(const Pm& answer, const AytoSettings* settings)
         }
     }
 
-    // Print a summary of the game, the guesses made in each week.
-    cout << "Results:" << endl;
-    for (unsigned int i = 0; i < tbGuessesAlreadyMade->size(); ++i) {
-        int intWidth = (tbGuessesAlreadyMade->size() < 10 ? 1 : 2);
-        cout << "[Week " << setw(intWidth) << (i + 1) << "] ";
-        if (settings->_isPrintNumbersMode) {
-            cout << getPrintableNumbers(tbGuessesAlreadyMade->get(i).toString())
-                 << ", "
-                 << getPrintableNumbers(pmGuessesAlreadyMade->get(i))
-                 << endl;
-        } else {
-            cout << getPrintableNames(tbGuessesAlreadyMade->get(i),
-                                      settings->_femaleNames,
-                                      settings->_maleNames)
-                 << endl
-                 << getPrintableNames(pmGuessesAlreadyMade->get(i),
-                                      settings->_femaleNames,
-                                      settings->_maleNames)
-                 << endl;
+    int numWeeks = int(record._weeks.size());
+    if (isLive) {
+        printResults(cout, record, settings);
+    } else if (settings->_resultWriter) {
+        settings->_resultWriter->write(record);
+        if (settings->_transcriptMinWeeks >= 0 && numWeeks > settings->_transcriptMinWeeks) {
+            stringstream transcript;
+            printTranscript(transcript, record, settings);
+            if (settings->_resultWriter->isBinaryFormat()) {
+                cout << transcript.str() << flush;
+            } else {
+                settings->_resultWriter->writeText(transcript.str());
+            }
         }
     }
 
     delete tbGuessesAlreadyMade;
     delete pmGuessesAlreadyMade;
     delete possibleAnswers;
+    delete histograms;
+    delete speculator;
+
+    return numWeeks;
 }
 
-Pm getRandomPerfectMatching() {
+Pm getRandomPerfectMatching(std::mt19937* rng) {
+    // Fisher-Yates: position last may keep its own digit, or every
+    // permutation would be a single cycle.
     Pm p = DIGITS;
     int last = (int) p.size();
     while (--last > 0) {
-        int i = rand() % last;
+        int i = std::uniform_int_distribution<int>(0, last)(*rng);
         char tmp = p[last];
         p[last] = p[i];
         p[i] = tmp;
@@ -8,17 +8,36 @@
 #ifndef GUARD_AYTO_H
 #define GUARD_AYTO_H
 
+#include <atomic>
 #include <map>
 #include <mutex>
+#include <ostream>
+#include <random>
+#include <vector>
+#include "AnswerTrie.h"
+#include "DecisionTree.h"
+#include "GuessHistory.h"
+#include "MinimaxCostModel.h"
+#include "MinimaxHistograms.h"
+#include "MinimaxWorkers.h"
+#include "PoolBuilder.h"
 #include "PerfectMatching.h"
 #include "PerfectMatchingSet.h"
+#include "ResultWriter.h"
+#include "ScoringPolicy.h"
 #include "TruthBooth.h"
 #include "TruthBoothSet.h"
 
+#define NUM_THREADS (10)      // Number of chunks, and threads, to use during minimax.
+#define POOL_FILENAME ("scripts/pool.txt") // Default location of fixed guess pool.
+#define SOLVE_BELOW (50)      // Solve exactly from weeks starting with <= this # left.
+#define OPTIMAL_EXTRA_CANDIDATES (10) // Non-answers the solver tries per Perfect Matching.
+
 using std::map;
 using std::mutex;
 
 typedef PerfectMatching Pm;
+typedef PerfectMatchingRank PmRank;
 typedef PerfectMatchingSet PmSet;
 typedef TruthBooth Tb;
 typedef TruthBoothSet TbSet;
@@ -28,24 +47,89 @@ typedef TruthBoothSet TbSet;
  */
 typedef struct AreYouTheOneSettings {
     std::string _fileToRead;
+    std::string _checkpointFile;              // Results file for -a or merge.
+    std::vector<std::string> _filesToMerge;   // Inputs of the merge subcommand.
+    std::string _resultsFile;                 // Where quiet mode writes records.
+    std::string _solveTreeFile;               // Where --solve-tree writes its tree.
+    std::string _treeFile;                    // Decision tree to play from, if any.
+    int _shardIndex;                          // Which rank range to run in -a mode.
+    int _numShards;                           // Number of rank ranges in -a mode.
+    int _numWorkers;                          // Worker processes for minimax.
+    int _workerTimeoutSeconds;                // Time a worker gets for one unit.
+    int _solveBelow;                          // Largest state --solve-tree solves.
+    int _numLookaheadBooths;                  // Booths expanded by --lookahead, 0 for off.
+    int _numSamples;                          // Answers drawn by --sample, 0 for off.
+    int _numParallelGames;                    // Sampled games played at once.
+    int _numMinimaxThreads;                   // Threads per minimax, 0 for one per chunk.
+    double _targetWidth;                      // Stop sampling at this CI width, 0 for never.
+    unsigned int _seed;                       // Seed for sampling and --build-pool.
+    double _weekBudgetSeconds;                // Minimax time budget, 0 for fixed stages.
+    int _transcriptMinWeeks;                  // Quiet mode prints games over this.
     bool _isAllPermutationsMode;
+    bool _isBinaryResults;
+    bool _isBuildPoolMode;
+    bool _isIncrementalMode;                  // Keep minimax histograms across weeks.
     bool _isInteractiveMode;
+    bool _isMergeMode;
+    bool _isNumaMode;                         // Pin minimax threads to NUMA nodes.
     bool _isPrintNumbersMode;
+    bool _isQuietMode;
     bool _isReadFromFileMode;
+    bool _isResumeMode;
     bool _isVerboseMode;
+    bool _isWorkerMode;                       // Serve minimax units on stdin/stdout.
+    MinimaxCoordinator* _minimaxCoordinator;  // Set when _numWorkers > 0.
+    MinimaxCostModel* _costModel;             // Set when _weekBudgetSeconds > 0.
+    DecisionTree* _decisionTree;              // Set when _treeFile is not empty.
+    ResultWriter* _resultWriter;              // Set in quiet mode.
+    PoolBuilderSettings _poolBuilder;         // Used with --build-pool.
+    ScoringPolicies _scoringPolicies;         // Set with --score, minimax by default.
     std::map<int, std::string>* _femaleNames; // Index maps to female name.
     std::map<char, std::string>* _maleNames;  // Char at index maps to male name.
     AreYouTheOneSettings() :
             _fileToRead(""),
+            _checkpointFile(""),
+            _resultsFile(""),
+            _solveTreeFile(""),
+            _treeFile(""),
+            _shardIndex(0),
+            _numShards(1),
+            _numWorkers(0),
+            _workerTimeoutSeconds(WORKER_TIMEOUT_SECONDS),
+            _solveBelow(SOLVE_BELOW),
+            _numLookaheadBooths(0),
+            _numSamples(0),
+            _numParallelGames(0),
+            _numMinimaxThreads(0),
+            _targetWidth(0),
+            _seed(1),
+            _weekBudgetSeconds(0),
+            _transcriptMinWeeks(-1),
             _isAllPermutationsMode(false),
+            _isBinaryResults(false),
+            _isBuildPoolMode(false),
+            _isIncrementalMode(false),
             _isInteractiveMode(false),
+            _isMergeMode(false),
+            _isNumaMode(false),
             _isPrintNumbersMode(false),
+            _isQuietMode(false),
             _isReadFromFileMode(false),
+            _isResumeMode(false),
             _isVerboseMode(true),
+            _isWorkerMode(false),
+            _minimaxCoordinator(nullptr),
+            _costModel(nullptr),
+            _decisionTree(nullptr),
+            _resultWriter(nullptr),
             _femaleNames(nullptr),
             _maleNames(nullptr)
     {}
     ~AreYouTheOneSettings() {
+        delete _minimaxCoordinator;
+        delete _costModel;
+        delete _decisionTree;
+        delete _resultWriter;
         if (!_isPrintNumbersMode) {
             delete _femaleNames;
             delete _maleNames;
@@ -61,24 +145,33 @@ typedef struct AreYouTheOneSettings {
 struct ArgsForMinimaxThread {
     int _threadId;                   // ID of thread taking these args.
     const PmSet* _possibleAnswers;   // All permutations still possible to be the answer.
+    const AnswerTrie* _answerTrie;   // The same answers as a trie, shared read-only.
     const PmSet* _possibleGuesses;   // The chunk of potential queries to evaluate.
-    const PmSet* _guessesAlreadyMade;// All queries made so far.
-    std::map<Pm, int>* _bestGuesses; // Where each thread will store it's best query.
-    std::mutex* _writeLock;          // Mutex for the shared _best_queries map.
+    const GuessHistory* _guessesAlreadyMade; // All queries made so far.
+    std::vector<std::pair<Pm, long> >* _bestGuesses; // Slot _threadId gets the chunk's best query.
+    const std::atomic<bool>* _isCancelled; // Stop early when set, if not null.
+    ScoringPolicy _scoringPolicy;    // How to score each query's histogram.
+    bool _isNodeLocal;               // Copy the chunk too, onto this thread's NUMA node.
     ArgsForMinimaxThread(            // Wordy initializer, but blame it on thread api.
             int threadId,
             const PmSet* possibleAnswers,
+            const AnswerTrie* answerTrie,
             const PmSet* possibleGuesses,
-            const PmSet* guessesAlreadyMade,
-            std::map<Pm, int>* bestGuesses,
-            mutex* writeLock)
+            const GuessHistory* guessesAlreadyMade,
+            std::vector<std::pair<Pm, long> >* bestGuesses,
+            const std::atomic<bool>* isCancelled = nullptr,
+            ScoringPolicy scoringPolicy = MINIMAX_SCORE,
+            bool isNodeLocal = false)
             :
             _threadId(threadId),
             _possibleAnswers(possibleAnswers),
+            _answerTrie(answerTrie),
             _possibleGuesses(possibleGuesses),
             _guessesAlreadyMade(guessesAlreadyMade),
             _bestGuesses(bestGuesses),
-            _writeLock(writeLock)
+            _isCancelled(isCancelled),
+            _scoringPolicy(scoringPolicy),
+            _isNodeLocal(isNodeLocal)
     {}
 };
 
@@ -90,21 +183,96 @@ struct ArgsForMinimaxThread {
  */
 void getBestGuessFromSubset(const ArgsForMinimaxThread* argsForMinimaxThread);
 
+/**
+ * Get the stage of minimax to use for the next Perfect Matching guess.
+ * @param possibleAnswers Remaining possibilities for the answer.
+ * @param costModel Chooses the stage within a time budget, or nullptr to
+ * use the fixed thresholds START_PART_MM and START_FULL_MM.
+ * @return Stage chosen by the number of remaining answers.
+ */
+MinimaxStage getMinimaxStage(const PmSet* possibleAnswers,
+                             const MinimaxCostModel* costModel = nullptr);
+
+/**
+ * Get the fixed pool of guesses used while many answers remain. The pool is
+ * read from POOL_FILENAME, or the file set by setFixedPoolFilename, on first
+ * use and kept for the life of the process.
+ * @return The pool, shared by all callers.
+ */
+const PmSet* getFixedPool();
+
+/**
+ * Read the fixed pool from another file. Only has an effect before the pool
+ * is first used.
+ * @param filename Pool file, one permutation of DIGITS per line.
+ * @return False if the pool was already read, from a different file.
+ */
+bool setFixedPoolFilename(const std::string& filename);
+
+/**
+ * How to run minimax for one Perfect Matching guess. Every field is
+ * optional: by default minimax runs one thread per chunk, counts afresh,
+ * and switches stages at fixed thresholds.
+ */
+struct MinimaxOptions {
+    MinimaxCoordinator* _coordinator;      // Worker processes, or nullptr for threads.
+    MinimaxHistograms* _histograms;        // Kept across weeks of a game, or nullptr.
+    const MinimaxCostModel* _costModel;    // Chooses the stage, or nullptr for thresholds.
+    const std::atomic<bool>* _isCancelled; // Give up when set; the result is then meaningless.
+    int _numThreads;                       // Threads for the NUM_THREADS chunks, 0 for one each.
+    ScoringPolicies _scoringPolicies;      // How each stage scores candidates.
+    bool _isNumaAware;                     // Pin threads and keep their data node-local.
+    MinimaxOptions() :
+            _coordinator(nullptr),
+            _histograms(nullptr),
+            _costModel(nullptr),
+            _isCancelled(nullptr),
+            _numThreads(0),
+            _isNumaAware(false)
+    {}
+};
+
+/**
+ * Find the best guess in each chunk of candidates from their histograms,
+ * the same way getBestGuessFromSubset does by counting.
+ * @param histograms Up-to-date histograms of the concatenated chunks.
+ * @param chunks Candidate guesses, in the order they were passed to update.
+ * @param numChunks Number of chunks.
+ * @param guessesAlreadyMade Guesses already submitted, never chosen again.
+ * @param numPossibleAnswers Number of answers counted in the histograms.
+ * @param scoringPolicy How to score each histogram.
+ * @param bestGuesses Gets the best guess of chunk i and its score in slot i.
+ */
+void getBestGuessesFromHistograms(const MinimaxHistograms* histograms,
+                                  PmSet** chunks,
+                                  int numChunks,
+                                  const GuessHistory* guessesAlreadyMade,
+                                  long numPossibleAnswers,
+                                  ScoringPolicy scoringPolicy,
+                                  std::vector<std::pair<Pm, long> >* bestGuesses);
+
 /**
  * Apply minimax algorithm to find the best next PerfectMatching to guess.
  * @param possibleAnswers Remaining possibilities for the answer.
  * @param guessesAlreadyMade Guesses already submitted in Perfect Matching stage.
+ * @param options Workers, histograms, cost model, cancellation, threads and
+ * scoring policies. Histograms are only used for the pool and partial stages.
  * @return The best guess as determined by the minimax algorithm.
  */
-Pm getNextGuessUsingMinimax(const PmSet* possibleAnswers, const PmSet* guessesAlreadyMade);
+Pm getNextGuessUsingMinimax(const PmSet* possibleAnswers,
+                            const PmSet* guessesAlreadyMade,
+                            const MinimaxOptions& options = MinimaxOptions());
 
 /**
  * Find the best next PerfectMatching to guess. May not require minimax.
  * @param possibleAnswers Remaining possibilities for the answer.
  * @param guessesAlreadyMade Guesses already submitted in Perfect Matching stage.
+ * @param options How to run minimax, if it is needed.
  * @return Best guess as determined by the minimax algorithm.
  */
-Pm getNextPerfectMatchingGuess(const PmSet* possibleAnswers, const PmSet* guessesAlreadyMade);
+Pm getNextPerfectMatchingGuess(const PmSet* possibleAnswers,
+                               const PmSet* guessesAlreadyMade,
+                               const MinimaxOptions& options = MinimaxOptions());
 
 /**
  * Find the best next TruthBooth to guess. Chooses the pair which occurs in
@@ -116,12 +284,118 @@ Pm getNextPerfectMatchingGuess(const PmSet* possibleAnswers, const PmSet* guesse
  */
 Tb getNextTruthBoothGuess(const PmSet* possibleAnswers, const TbSet* guessesAlreadyMade);
 
+/**
+ * Truth Booth for a week, and the Perfect Matching to follow it under
+ * either feedback, chosen together by getNextGuessesUsingLookahead.
+ */
+struct LookaheadGuesses {
+    Tb _truthBooth;
+    Pm _perfectMatchingIfMatch;
+    Pm _perfectMatchingIfNoMatch;
+};
+
+/**
+ * Choose the week's Truth Booth by the Perfect Matching that would follow
+ * it. Expands the numTruthBooths booths closest to splitting the answers in
+ * half, finds the best minimax guess on each side of each, and keeps the
+ * booth whose two sides score best together (see combineScores).
+ * @param possibleAnswers Remaining possibilities for the answer.
+ * @param tbGuessesAlreadyMade Guesses already submitted in Truth Booth stage.
+ * @param pmGuessesAlreadyMade Guesses already submitted in Perfect Matching stage.
+ * @param numTruthBooths Number of booths to expand.
+ * @param options How to run minimax. Only the cost model, threads and
+ * scoring policies are used.
+ * @return The booth and the guess to make after each of its feedbacks.
+ */
+LookaheadGuesses getNextGuessesUsingLookahead(const PmSet* possibleAnswers,
+                                              const TbSet* tbGuessesAlreadyMade,
+                                              const PmSet* pmGuessesAlreadyMade,
+                                              int numTruthBooths,
+                                              const MinimaxOptions& options = MinimaxOptions());
+
 /**
  * Run a single season of Are You The One.
  * @param answer Hidden answer, i.e., the matching of contestants.
  * @param settings Settings for the simulator, e.g., interactive and verbose.
+ * @return Number of weeks it took to find the answer.
+ */
+int runAreYouTheOne(const PerfectMatching& answer, const AytoSettings* settings);
+
+/**
+ * Run a season for every answer in this process's shard of the rank space,
+ * checkpointing progress and statistics to the results file if one is set.
+ * @param settings Settings for the simulator, including shard and checkpoint.
+ */
+void runAllAnswers(const AytoSettings* settings);
+
+/**
+ * Play games on up to _numSamples answers drawn at random with _seed, with
+ * _numParallelGames games at a time, and print estimates of the weeks
+ * distribution, the chance of losing and the time per week. Stops early
+ * once the confidence interval of the mean weeks is narrower than
+ * _targetWidth. Statistics cover the answers in the order drawn, so they
+ * only depend on the seed and not on which games finish first.
+ * @param settings Settings for the simulator, including the sample.
+ */
+void runSampledAnswers(const AytoSettings* settings);
+
+/**
+ * Solve the end game of each answer exactly and write the optimal moves to
+ * a decision tree. Each game is played with the usual strategy until a week
+ * starts with at most _solveBelow answers left; the optimal solver takes over
+ * from there, and is compared with the usual strategy from the same states.
+ * @param answers Answers whose end games to solve.
+ * @param settings Settings naming the tree file and the size to solve from.
+ */
+void runOptimalSolver(const PmSet* answers, const AytoSettings* settings);
+
+/**
+ * Combine the results files of a sharded run into a single results file
+ * with one weeks histogram and worst-case list.
+ * @param settings Settings naming the output and input results files.
+ */
+void mergeResultFiles(const AytoSettings* settings);
+
+/**
+ * Print the answer of a game, as at the start of its transcript.
+ * @param out Stream to print to.
+ * @param answer Hidden answer of the game.
+ * @param settings Settings for the simulator, e.g., names or numbers.
+ */
+void printAnswer(std::ostream& out, const Pm& answer, const AytoSettings* settings);
+
+/**
+ * Print the Truth Booth guess of a week, its feedback and what remains.
+ * @param out Stream to print to.
+ * @param week Guesses and feedback of the week.
+ * @param settings Settings for the simulator, e.g., names or numbers.
+ */
+void printTruthBoothFeedback(std::ostream& out, const WeekRecord& week, const AytoSettings* settings);
+
+/**
+ * Print the Perfect Matching guess of a week, its feedback and what remains.
+ * @param out Stream to print to.
+ * @param week Guesses and feedback of the week.
+ * @param settings Settings for the simulator, e.g., names or numbers.
+ */
+void printPerfectMatchingFeedback(std::ostream& out, const WeekRecord& week, const AytoSettings* settings);
+
+/**
+ * Print the summary at the end of a game, the guesses made in each week.
+ * @param out Stream to print to.
+ * @param record The finished game.
+ * @param settings Settings for the simulator, e.g., names or numbers.
+ */
+void printResults(std::ostream& out, const GameRecord& record, const AytoSettings* settings);
+
+/**
+ * Print the full transcript of a finished game, as it would have been
+ * printed while the game was played.
+ * @param out Stream to print to.
+ * @param record The finished game.
+ * @param settings Settings for the simulator, e.g., names or numbers.
  */
-void runAreYouTheOne(const PerfectMatching& answer, const AytoSettings* settings);
+void printTranscript(std::ostream& out, const GameRecord& record, const AytoSettings* settings);
 
 /**
  * Convert a PerfectMatching to a printable representation using names of
@@ -155,9 +429,10 @@ std::string getPrintableNames(const TruthBooth& truthBooth,
 std::string getPrintableNumbers(const PerfectMatching& perfectMatching);
 
 /**
- * Get a random perfect matching.
+ * Get a random perfect matching, every one equally likely.
+ * @param rng Random number generator to draw from.
  * @return Random perfect matching, permutation of 0123456789.
  */
-Pm getRandomPerfectMatching();
+Pm getRandomPerfectMatching(std::mt19937* rng);
 
 #endif
@@ -0,0 +1,169 @@
+/**
+ * main.cpp
+ * Christopher Chute
+ *
+ * Command-line front end of the Are You The One? simulator. Everything it
+ * runs lives in ayto.cpp and the library around it.
+ */
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <iostream>
+#include <thread>
+#include <unistd.h>
+#include "NumaTopology.h"
+#include "ayto.h"
+
+using std::cout;
+using std::endl;
+using std::thread;
+
+int main(int argc, char** argv) {
+    AytoSettings* settings = new AytoSettings();
+
+    if (settings->initializeFromArgs(argc, argv)) {
+        if (settings->_numWorkers > 0) {
+            settings->_minimaxCoordinator = new MinimaxCoordinator(settings->_numWorkers,
+                                                                   settings->_workerTimeoutSeconds);
+        }
+        if (settings->_isNumaMode) {
+            int numNodes = NumaTopology::get().getNumNodes();
+            if (numNodes > 1) {
+                cout << "NUMA mode: minimax threads pinned across " << numNodes << " nodes." << endl;
+            } else {
+                cout << "NUMA mode: only one node, threads are not pinned." << endl;
+            }
+        }
+        if (settings->_numSamples > 0 && settings->_numParallelGames == 0) {
+            settings->_numParallelGames = std::max(int(thread::hardware_concurrency()), 1);
+        }
+        if (settings->_numSamples > 0 && settings->_numParallelGames > 1 &&
+            settings->_numWorkers == 0) {
+            // Games in parallel split the cores between their minimax threads.
+            settings->_numMinimaxThreads = std::max(
+                    int(thread::hardware_concurrency()) / settings->_numParallelGames, 1);
+        }
+        if (settings->_weekBudgetSeconds > 0) {
+            // Minimax runs in NUM_THREADS chunks on threads, or in units on every worker.
+            int numThreads = settings->_numMinimaxThreads > 0 ? settings->_numMinimaxThreads :
+                    int(thread::hardware_concurrency());
+            int numParallel = settings->_numWorkers > 0 ? settings->_numWorkers :
+                    std::min(numThreads, NUM_THREADS);
+            settings->_costModel = new MinimaxCostModel(settings->_weekBudgetSeconds,
+                                                        std::max(numParallel, 1));
+            settings->_costModel->calibrate();
+        }
+        if (!settings->_treeFile.empty()) {
+            settings->_decisionTree = new DecisionTree();
+            if (!settings->_decisionTree->loadFromFile(settings->_treeFile)) {
+                cout << "Could not read tree " << settings->_treeFile << "." << endl;
+                delete settings;
+                return EXIT_FAILURE;
+            }
+        }
+        if (!settings->_resultsFile.empty()) {
+            // A resumed run keeps the records of the games in its checkpoint.
+            const char* mode = settings->_isResumeMode ?
+                    (settings->_isBinaryResults ? "a+b" : "a+") :
+                    (settings->_isBinaryResults ? "wb" : "w");
+            FILE* resultsFile = fopen(settings->_resultsFile.c_str(), mode);
+            if (!resultsFile) {
+                cout << "Could not open " << settings->_resultsFile << "." << endl;
+                delete settings;
+                return EXIT_FAILURE;
+            }
+            settings->_resultWriter = new ResultWriter(resultsFile,
+                                                       settings->_isBinaryResults,
+                                                       true);
+        } else if (settings->_isQuietMode) {
+            settings->_resultWriter = new ResultWriter(stdout, false, false);
+        }
+
+        if (settings->_isWorkerMode) {
+            runMinimaxWorker(STDIN_FILENO, STDOUT_FILENO);
+        } else if (settings->_isBuildPoolMode) {
+            settings->_poolBuilder._numThreads = NUM_THREADS;
+            settings->_poolBuilder._seed = settings->_seed;
+            settings->_poolBuilder._seedPoolFile = POOL_FILENAME;
+            settings->_poolBuilder._scoringPolicy =
+                    settings->_scoringPolicies._forStage[POOL_MINIMAX];
+            if (!buildGuessPool(settings->_poolBuilder)) {
+                delete settings;
+                return EXIT_FAILURE;
+            }
+        } else if (!settings->_solveTreeFile.empty()) {
+            PmSet* answers = new PmSet();
+            if (settings->_isReadFromFileMode) {
+                answers->populateFromFile(settings->_fileToRead);
+            } else {
+                std::mt19937 rng(unsigned(std::time(nullptr)));
+                answers->add(getRandomPerfectMatching(&rng));
+            }
+            runOptimalSolver(answers, settings);
+            delete answers;
+        } else if (settings->_numSamples > 0) {
+            runSampledAnswers(settings);
+        } else if (settings->_isMergeMode) {
+            mergeResultFiles(settings);
+        } else if (settings->_isAllPermutationsMode) {
+            runAllAnswers(settings);
+        } else if (settings->_isReadFromFileMode) {
+            cout << "Reading answers from " << settings->_fileToRead << "." << endl;
+            PmSet *answers = new PmSet();
+            answers->populateFromFile(settings->_fileToRead);
+            for (PmSet::const_iterator answer = answers->begin();
+                 answer != answers->end();
+                 ++answer) {
+                runAreYouTheOne(*answer, settings);
+            }
+            delete answers;
+        } else if (settings->_isInteractiveMode) {
+            cout << "Interactive mode. I think I'm going to win." << endl;
+            runAreYouTheOne("", settings);
+        } else {
+            cout << "Running on a random answer." << endl;
+            std::mt19937 rng(unsigned(std::time(nullptr)));
+            Pm answer = getRandomPerfectMatching(&rng);
+            runAreYouTheOne(answer, settings);
+        }
+    } else {
+        cout << "usage: ./ayto" << endl;
+        cout << "\t[-a | -all]     * Run on all permutations" << endl;
+        cout << "\t  [--shard <i>/<N>]     * Only run the i-th of N rank ranges" << endl;
+        cout << "\t  [--checkpoint <file>] * Save progress and results to file" << endl;
+        cout << "\t  [--resume]            * Continue from the checkpoint file" << endl;
+        cout << "\t[--sample <M>]  * Estimate results from M random answers" << endl;
+        cout << "\t  [--ci-width <weeks>] * Stop once the mean weeks is known this closely" << endl;
+        cout << "\t  [--parallel <N>]     * Play N games at once (default one per core)" << endl;
+        cout << "\t  [--seed <N>]         * Seed for drawing answers (default 1)" << endl;
+        cout << "\t[-f <filename>] * Run on permutations in file" << endl;
+        cout << "\t[-i]            * Interactive, user gives feedback" << endl;
+        cout << "\t[-v]            * Verbose mode, more printing" << endl;
+        cout << "\t[-q]            * Quiet, one line per game instead of transcripts" << endl;
+        cout << "\t[-o <filename>] * Quiet, one record per game written to file" << endl;
+        cout << "\t  [-b]            * Binary records instead of text" << endl;
+        cout << "\t  [-t <N>]        * Full transcript of games over N weeks" << endl;
+        cout << "\t[--workers <N>] * Run minimax on N worker processes" << endl;
+        cout << "\t  [--worker-timeout <seconds>] * Give up on a unit after this long (default 600)" << endl;
+        cout << "\t[--numa]        * Pin minimax threads to NUMA nodes, data node-local" << endl;
+        cout << "\t[--incremental] * Update minimax histograms across weeks" << endl;
+        cout << "\t[--budget <seconds>] * Choose minimax stages to fit a time per week" << endl;
+        cout << "\t[--score [<stage>=]<policy>] * Score guesses by minimax, expected, entropy or parts" << endl;
+        cout << "\t[--build-pool <filename>] * Search for a new guess pool" << endl;
+        cout << "\t  [--pool-size <N>]       * Guesses in the pool (default 200)" << endl;
+        cout << "\t  [--pool-candidates <N>] * Random guesses to choose from (default 2000)" << endl;
+        cout << "\t  [--seed <N>]            * Seed for drawing candidates (default 1)" << endl;
+        cout << "\t[--tree <filename>] * Play moves from a decision tree where it has them" << endl;
+        cout << "\t[--solve-tree <filename>] * Solve end games exactly, write their tree" << endl;
+        cout << "\t  [--solve-below <N>]     * Solve from weeks starting with <= N left (default 50)" << endl;
+        cout << "\t  [-f <filename>]         * End games of answers in file, else a random one" << endl;
+        cout << "usage: ./ayto merge <output> <results>..." << endl;
+        cout << "\tCombine results files of a sharded -a run" << endl;
+    }
+
+    delete settings;
+
+    return EXIT_SUCCESS;
+}
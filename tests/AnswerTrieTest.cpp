@@ -0,0 +1,168 @@
+/**
+ * AnswerTrieTest.cpp
+ * Christopher Chute
+ *
+ * Check AnswerTrie histograms against numInCommon on every answer: random
+ * sets of answers, answers whose prefix holds all of the guess's later
+ * digits so whole subtrees are skipped, answers equal to or one swap away
+ * from the guess so the deepest nodes count, and answers listed more than
+ * once, as a file given with -f may list them. Run with 'make test'.
+ */
+
+#include <algorithm>
+#include <cstdio>
+#include <random>
+#include <vector>
+#include "AnswerTrie.h"
+#include "PerfectMatchingSet.h"
+#include "PerfectMatchingUniverse.h"
+
+#define NUM_SETS (20)             // Random sets of answers.
+#define NUM_FILTERED_SETS (6)     // Sets left by filtering the universe.
+#define NUM_GUESSES (40)          // Guesses checked against each set.
+
+#define CHECK(condition) checkThat((condition), #condition, __FILE__, __LINE__)
+
+using std::vector;
+
+typedef PerfectMatching Pm;
+typedef PerfectMatchingRank PmRank;
+typedef PerfectMatchingSet PmSet;
+
+static int numFailures = 0;
+
+static void checkThat(bool isTrue, const char* condition, const char* file, int line) {
+    if (!isTrue) {
+        printf("%s:%d: failed: %s\n", file, line, condition);
+        ++numFailures;
+    }
+}
+
+// Compare the trie's histogram for a guess with a flat loop over the answers.
+static void checkGuess(const AnswerTrie& trie, const vector<PmRank>& answers, const Pm& guess) {
+    const PerfectMatchingUniverse& universe = PerfectMatchingUniverse::get();
+    int expected[PERM_LENGTH + 1] = {0};
+    for (vector<PmRank>::const_iterator it = answers.begin(); it != answers.end(); ++it) {
+        ++expected[numInCommon(guess, universe.at(*it))];
+    }
+    int actual[PERM_LENGTH + 1];
+    trie.countResponses(guess, actual);
+    CHECK(std::equal(expected, expected + PERM_LENGTH + 1, actual));
+}
+
+// Check random guesses, and guesses from among the answers, against a list.
+static void checkTrie(const AnswerTrie& trie, const vector<PmRank>& answers, std::mt19937& random) {
+    const PerfectMatchingUniverse& universe = PerfectMatchingUniverse::get();
+    CHECK(trie.getNumAnswers() == answers.size());
+    for (int g = 0; g < NUM_GUESSES; ++g) {
+        PmRank guess = PmRank(random() % NUM_PERMS);
+        if (g % 2 && !answers.empty()) {
+            guess = answers[random() % answers.size()];
+        }
+        checkGuess(trie, answers, universe.at(guess));
+    }
+}
+
+// Answers whose prefix holds every digit the guess has after it: below
+// that prefix the guess has no digit left to agree with.
+static void testSkippedSubtrees(std::mt19937& random) {
+    const PerfectMatchingUniverse& universe = PerfectMatchingUniverse::get();
+    for (int prefixLength = PERM_LENGTH / 2; prefixLength < PERM_LENGTH; ++prefixLength) {
+        Pm guess = universe.at(PmRank(random() % NUM_PERMS));
+        vector<PmRank> answers;
+        for (PmRank r = 0; r < NUM_PERMS; r += PmRank(1 + random() % 64)) {
+            const Pm& answer = universe.at(r);
+            bool isLaterDigitInPrefix = true;
+            for (int i = prefixLength; i < PERM_LENGTH; ++i) {
+                isLaterDigitInPrefix = isLaterDigitInPrefix &&
+                        answer.find(guess[i]) < size_t(prefixLength);
+            }
+            if (isLaterDigitInPrefix || random() % 8 == 0) {
+                answers.push_back(r);
+            }
+        }
+        AnswerTrie trie(answers);
+        checkGuess(trie, answers, guess);
+    }
+}
+
+// The guess itself, and answers one swap from it, end at the deepest nodes
+// with all but the implied last digit agreeing.
+static void testDeepestNodes(std::mt19937& random) {
+    const PerfectMatchingUniverse& universe = PerfectMatchingUniverse::get();
+    for (int n = 0; n < NUM_SETS; ++n) {
+        Pm guess = universe.at(PmRank(random() % NUM_PERMS));
+        vector<PmRank> answers(1, getRank(guess));
+        for (int i = 0; i < PERM_LENGTH; ++i) {
+            for (int j = i + 1; j < PERM_LENGTH; ++j) {
+                Pm swapped(guess);
+                std::swap(swapped[i], swapped[j]);
+                answers.push_back(getRank(swapped));
+            }
+        }
+        AnswerTrie trie(answers);
+        checkGuess(trie, answers, guess);
+        int histogram[PERM_LENGTH + 1];
+        trie.countResponses(guess, histogram);
+        CHECK(histogram[PERM_LENGTH] == 1);
+        CHECK(histogram[PERM_LENGTH - 2] == PERM_LENGTH * (PERM_LENGTH - 1) / 2);
+    }
+}
+
+// Answers listed more than once count once per listing.
+static void testDuplicates(std::mt19937& random) {
+    for (int n = 0; n < NUM_SETS; ++n) {
+        vector<PmRank> answers;
+        size_t numDistinct = 1 + random() % 200;
+        for (size_t i = 0; i < numDistinct; ++i) {
+            PmRank r = PmRank(random() % NUM_PERMS);
+            answers.insert(answers.end(), 1 + random() % 3, r);
+        }
+        std::shuffle(answers.begin(), answers.end(), random);
+        AnswerTrie trie(answers);
+        checkTrie(trie, answers, random);
+    }
+}
+
+// Survivors of random filters, as minimax sees them.
+static void testFilteredSets(std::mt19937& random) {
+    const PerfectMatchingUniverse& universe = PerfectMatchingUniverse::get();
+    for (int n = 0; n < NUM_FILTERED_SETS; ++n) {
+        PmSet set;
+        set.populateAll();
+        const Pm& answer = universe.at(PmRank(random() % NUM_PERMS));
+        int numFilters = 2 + int(random() % 3);
+        for (int f = 0; f < numFilters; ++f) {
+            Pm guess = universe.at(PmRank(random() % NUM_PERMS));
+            set.filter(guess, numInCommon(guess, answer));
+        }
+        vector<PmRank> answers;
+        for (PmSet::const_iterator it = set.begin(); it != set.end(); ++it) {
+            answers.push_back(it.rank());
+        }
+        AnswerTrie trie(&set);
+        checkTrie(trie, answers, random);
+    }
+
+    // No answers at all.
+    vector<PmRank> none;
+    AnswerTrie empty(none);
+    CHECK(empty.getNumNodes() == 0);
+    checkGuess(empty, none, DIGITS);
+}
+
+int main() {
+    std::mt19937 random(5);
+
+    testSkippedSubtrees(random);
+    testDeepestNodes(random);
+    testDuplicates(random);
+    testFilteredSets(random);
+
+    if (numFailures > 0) {
+        printf("AnswerTrieTest: %d checks failed.\n", numFailures);
+        return 1;
+    }
+    printf("AnswerTrieTest: ok.\n");
+    return 0;
+}
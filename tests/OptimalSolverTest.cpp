@@ -0,0 +1,297 @@
+/**
+ * OptimalSolverTest.cpp
+ * Christopher Chute
+ *
+ * Check OptimalSolver against a brute-force search of the game tree on
+ * small end games, without renaming, bounds or cut-offs: exactly when
+ * Perfect Matchings come from the answers alone, and in the worst case when
+ * every guess one swap from an answer may be tried as well. Then play each
+ * answer through the solver's decision tree and check it takes the weeks
+ * solved for. End games of nearby answers make the swaps matter. Run with
+ * 'make test'.
+ */
+
+#include <algorithm>
+#include <cstdio>
+#include <map>
+#include <random>
+#include <utility>
+#include <vector>
+#include "DecisionTree.h"
+#include "OptimalSolver.h"
+#include "PerfectMatchingSet.h"
+#include "PerfectMatchingUniverse.h"
+
+#define NUM_RANDOM_STATES (4)     // End games left by random feedback.
+#define MIN_STATE_SIZE (3)        // Fewest answers in a random end game.
+#define MAX_STATE_SIZE (9)        // Most answers in a random end game.
+#define NUM_CLUSTERS (4)          // End games of nearby answers.
+#define NUM_SHUFFLED (4)          // Positions shuffled in a cluster.
+#define MIN_CLUSTER_SIZE (9)      // Fewest answers kept of a cluster.
+#define MAX_WEEKS (6)             // More than any end game here takes.
+#define NUM_SWAPS (PERM_LENGTH * (PERM_LENGTH - 1) / 2) // Guesses one swap from an answer.
+
+#define CHECK(condition) checkThat((condition), #condition, __FILE__, __LINE__)
+
+using std::map;
+using std::max;
+using std::pair;
+using std::vector;
+
+typedef PerfectMatching Pm;
+typedef PerfectMatchingRank PmRank;
+typedef PerfectMatchingSet PmSet;
+typedef TruthBooth Tb;
+typedef vector<Pm> Answers; // Sorted.
+
+static int numFailures = 0;
+
+static void checkThat(bool isTrue, const char* condition, const char* file, int line) {
+    if (!isTrue) {
+        printf("%s:%d: failed: %s\n", file, line, condition);
+        ++numFailures;
+    }
+}
+
+// Game tree search over every booth and every candidate guess, memoized.
+class BruteForce {
+private:
+    bool isWithSwaps;                              // Try guesses one swap from an answer.
+    map<pair<bool, Answers>, OptimalValue> values; // By week start or not, then answers.
+
+    vector<Pm> getCandidates(const Answers& answers) const {
+        vector<Pm> candidates(answers);
+        if (this->isWithSwaps) {
+            for (Answers::const_iterator it = answers.begin(); it != answers.end(); ++it) {
+                for (int i = 0; i < PERM_LENGTH; ++i) {
+                    for (int j = i + 1; j < PERM_LENGTH; ++j) {
+                        Pm swapped(*it);
+                        std::swap(swapped[i], swapped[j]);
+                        candidates.push_back(swapped);
+                    }
+                }
+            }
+        }
+        return candidates;
+    }
+
+public:
+    explicit BruteForce(bool w) : isWithSwaps(w) {}
+
+    OptimalValue solveWeek(const Answers& answers) {
+        if (answers.size() == 1) {
+            return OptimalValue(1, 1);
+        }
+        pair<bool, Answers> key(true, answers);
+        if (this->values.count(key)) {
+            return this->values[key];
+        }
+        OptimalValue best(1 << 30, 0);
+        bool isSplit = false;
+        for (int index = 0; index < PERM_LENGTH; ++index) {
+            for (int digit = 0; digit < PERM_LENGTH; ++digit) {
+                Tb tb(index, char('0' + digit));
+                Answers yes;
+                Answers no;
+                for (Answers::const_iterator it = answers.begin(); it != answers.end(); ++it) {
+                    (tb.isContainedIn(*it) ? yes : no).push_back(*it);
+                }
+                if (yes.empty() || no.empty()) {
+                    continue;
+                }
+                isSplit = true;
+                OptimalValue yesValue = this->solveGuess(yes);
+                OptimalValue noValue = this->solveGuess(no);
+                OptimalValue value(max(yesValue._worstWeeks, noValue._worstWeeks),
+                                   yesValue._totalWeeks + noValue._totalWeeks);
+                best = std::min(best, value);
+            }
+        }
+        if (!isSplit) {
+            best = this->solveGuess(answers);
+        }
+        this->values[key] = best;
+        return best;
+    }
+
+    OptimalValue solveGuess(const Answers& answers) {
+        if (answers.size() == 1) {
+            return OptimalValue(1, 1);
+        }
+        pair<bool, Answers> key(false, answers);
+        if (this->values.count(key)) {
+            return this->values[key];
+        }
+        OptimalValue best(1 << 30, 0);
+        vector<Pm> candidates = this->getCandidates(answers);
+        for (vector<Pm>::const_iterator guess = candidates.begin(); guess != candidates.end(); ++guess) {
+            vector<Answers> children(PERM_LENGTH + 1);
+            for (Answers::const_iterator it = answers.begin(); it != answers.end(); ++it) {
+                children[numInCommon(*guess, *it)].push_back(*it);
+            }
+            bool isInformative = true;
+            for (int r = 0; r <= PERM_LENGTH; ++r) {
+                isInformative = isInformative && children[r].size() < answers.size();
+            }
+            if (!isInformative) {
+                continue;
+            }
+            OptimalValue value(children[PERM_LENGTH].empty() ? 0 : 1, long(answers.size()));
+            for (int r = 0; r < PERM_LENGTH; ++r) {
+                if (!children[r].empty()) {
+                    OptimalValue childValue = this->solveWeek(children[r]);
+                    value._worstWeeks = max(value._worstWeeks, 1 + childValue._worstWeeks);
+                    value._totalWeeks += childValue._totalWeeks;
+                }
+            }
+            best = std::min(best, value);
+        }
+        this->values[key] = best;
+        return best;
+    }
+};
+
+// Answers left by random feedback on a random answer, between the sizes.
+static PmSet* getEndGame(std::mt19937& random) {
+    const PerfectMatchingUniverse& universe = PerfectMatchingUniverse::get();
+    while (true) {
+        PmSet* state = new PmSet();
+        state->populateAll();
+        const Pm answer = universe.at(PmRank(random() % NUM_PERMS));
+        while (state->size() > MAX_STATE_SIZE) {
+            if (random() % 2) {
+                Pm guess = universe.at(PmRank(random() % NUM_PERMS));
+                state->filter(guess, numInCommon(guess, answer));
+            } else {
+                Tb tb(int(random() % PERM_LENGTH), char('0' + random() % PERM_LENGTH));
+                state->filter(tb, tb.isContainedIn(answer));
+            }
+        }
+        if (state->size() >= MIN_STATE_SIZE) {
+            return state;
+        }
+        delete state;
+    }
+}
+
+// Some orders of the digits at a few positions of a random answer. Answers
+// alone often split these worse than guesses one swap away.
+static PmSet* getCluster(std::mt19937& random) {
+    const PerfectMatchingUniverse& universe = PerfectMatchingUniverse::get();
+    Pm answer = universe.at(PmRank(random() % NUM_PERMS));
+    vector<int> positions;
+    for (int i = 0; i < PERM_LENGTH; ++i) {
+        positions.push_back(i);
+    }
+    std::shuffle(positions.begin(), positions.end(), random);
+    positions.resize(NUM_SHUFFLED);
+    std::sort(positions.begin(), positions.end());
+
+    vector<char> digits;
+    for (vector<int>::const_iterator it = positions.begin(); it != positions.end(); ++it) {
+        digits.push_back(answer[*it]);
+    }
+    std::sort(digits.begin(), digits.end());
+    vector<PmRank> ranks;
+    do {
+        for (int i = 0; i < NUM_SHUFFLED; ++i) {
+            answer[positions[i]] = digits[i];
+        }
+        ranks.push_back(getRank(answer));
+    } while (std::next_permutation(digits.begin(), digits.end()));
+    std::shuffle(ranks.begin(), ranks.end(), random);
+    ranks.resize(MIN_CLUSTER_SIZE + random() % 4);
+    std::sort(ranks.begin(), ranks.end());
+
+    PmSet* state = new PmSet();
+    for (vector<PmRank>::const_iterator it = ranks.begin(); it != ranks.end(); ++it) {
+        state->addRank(*it);
+    }
+    return state;
+}
+
+// Play every answer by the tree's moves, the last answer left being guessed.
+static OptimalValue playTree(const DecisionTree& tree, const PmSet* endGame) {
+    OptimalValue played;
+    for (PmSet::const_iterator answer = endGame->begin(); answer != endGame->end(); ++answer) {
+        PmSet state(endGame->begin(), endGame->end());
+        int numWeeks = 0;
+        bool isWon = false;
+        while (!isWon && numWeeks < MAX_WEEKS) {
+            ++numWeeks;
+            Tb tb;
+            if (state.size() > 1 && tree.findTruthBooth(&state, &tb)) {
+                state.filter(tb, tb.isContainedIn(*answer));
+            }
+            Pm guess = state.size() == 1 ? state.get(0) : "";
+            CHECK(state.size() == 1 || tree.findPerfectMatching(&state, &guess));
+            if (guess.empty()) {
+                break;
+            }
+            int numCorrect = numInCommon(guess, *answer);
+            isWon = numCorrect == PERM_LENGTH;
+            state.filter(guess, numCorrect);
+        }
+        CHECK(isWon);
+        played._worstWeeks = max(played._worstWeeks, numWeeks);
+        played._totalWeeks += numWeeks;
+    }
+    return played;
+}
+
+// Check the solver on one end game, with and without extra candidates.
+// Returns whether the extra candidates beat the answers alone.
+static bool checkEndGame(const PmSet* endGame) {
+    Answers answers(endGame->begin(), endGame->end());
+    std::sort(answers.begin(), answers.end());
+
+    // Answers only: the same search, value for value.
+    OptimalSolver answersOnly(1, 0);
+    OptimalValue solved = answersOnly.solve(endGame);
+    OptimalValue expected = BruteForce(false).solveWeek(answers);
+    CHECK(solved._worstWeeks == expected._worstWeeks);
+    CHECK(solved._totalWeeks == expected._totalWeeks);
+
+    DecisionTree tree;
+    answersOnly.addMoves(endGame, &tree);
+    OptimalValue played = playTree(tree, endGame);
+    CHECK(played._worstWeeks == solved._worstWeeks);
+    CHECK(played._totalWeeks == solved._totalWeeks);
+
+    // Every guess one swap from an answer: extras are only tried where the
+    // answers fall short of the lower bound, so only the worst case is exact.
+    OptimalSolver withSwaps(2, int(answers.size() * NUM_SWAPS));
+    OptimalValue solvedWithSwaps = withSwaps.solve(endGame);
+    OptimalValue expectedWithSwaps = BruteForce(true).solveWeek(answers);
+    CHECK(solvedWithSwaps._worstWeeks == expectedWithSwaps._worstWeeks);
+    CHECK(!(solved < solvedWithSwaps));
+
+    printf("OptimalSolverTest: %zu answers, worst %d, total %ld; with swaps worst %d, total %ld.\n",
+           answers.size(), solved._worstWeeks, solved._totalWeeks,
+           solvedWithSwaps._worstWeeks, solvedWithSwaps._totalWeeks);
+    return solvedWithSwaps < solved;
+}
+
+int main() {
+    std::mt19937 random(7);
+
+    for (int n = 0; n < NUM_RANDOM_STATES; ++n) {
+        PmSet* endGame = getEndGame(random);
+        checkEndGame(endGame);
+        delete endGame;
+    }
+    int numImproved = 0;
+    for (int n = 0; n < NUM_CLUSTERS; ++n) {
+        PmSet* endGame = getCluster(random);
+        numImproved += checkEndGame(endGame) ? 1 : 0;
+        delete endGame;
+    }
+    CHECK(numImproved > 0); // Otherwise the extra candidates went untested.
+
+    if (numFailures > 0) {
+        printf("OptimalSolverTest: %d checks failed.\n", numFailures);
+        return 1;
+    }
+    printf("OptimalSolverTest: ok.\n");
+    return 0;
+}
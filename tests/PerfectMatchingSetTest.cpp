@@ -0,0 +1,248 @@
+/**
+ * PerfectMatchingSetTest.cpp
+ * Christopher Chute
+ *
+ * Check PerfectMatchingSet against a brute-force list of ranks through
+ * every layout: filters that go from the universe to a bitset, to ranks and
+ * to packed matchings, adding to a packed set, arena and heap storage, and
+ * iterator arithmetic over a bitset. Run with 'make test'.
+ */
+
+#include <algorithm>
+#include <cstdio>
+#include <random>
+#include <vector>
+#include "PerfectMatchingSet.h"
+#include "PerfectMatchingUniverse.h"
+#include "ScratchArena.h"
+
+#define NUM_GAMES (8)             // Random games, alternating arena and heap.
+#define NUM_STEPS (12)            // Most filters per random game.
+#define NUM_CHUNKS (10)           // Chunks checked by copyIntoChunks.
+#define NUM_PROBES (50)           // Random permutations checked by contains.
+
+#define CHECK(condition) checkThat((condition), #condition, __FILE__, __LINE__)
+
+using std::vector;
+
+typedef PerfectMatching Pm;
+typedef PerfectMatchingRank PmRank;
+typedef PerfectMatchingSet PmSet;
+
+static int numFailures = 0;
+
+static void checkThat(bool isTrue, const char* condition, const char* file, int line) {
+    if (!isTrue) {
+        printf("%s:%d: failed: %s\n", file, line, condition);
+        ++numFailures;
+    }
+}
+
+// Hash of ranks in order, as PerfectMatchingSet::hash computes it.
+static uint64_t hashRanks(const vector<PmRank>& ranks) {
+    uint64_t hash = 14695981039346656037ULL;
+    for (vector<PmRank>::const_iterator it = ranks.begin(); it != ranks.end(); ++it) {
+        hash = (hash ^ *it) * 1099511628211ULL;
+    }
+    return hash;
+}
+
+// Check that a set lists exactly the expected ranks, in order, through every
+// way of reading it.
+static void checkSame(const PmSet* set, const vector<PmRank>& expected, std::mt19937& random) {
+    const PerfectMatchingUniverse& universe = PerfectMatchingUniverse::get();
+    CHECK(set->size() == expected.size());
+    CHECK(set->hash() == hashRanks(expected));
+    CHECK(size_t(set->end() - set->begin()) == expected.size());
+
+    size_t i = 0;
+    bool isInOrder = true;
+    for (PmSet::const_iterator it = set->begin(); it != set->end() && i < expected.size(); ++it, ++i) {
+        isInOrder = isInOrder && it.rank() == expected[i] && *it == universe.at(expected[i]);
+    }
+    CHECK(isInOrder);
+    CHECK(i == expected.size());
+    if (expected.empty()) {
+        return;
+    }
+    CHECK(set->get(0) == universe.at(expected[0]));
+
+    // Jump into the middle and back, linear over a bitset.
+    for (int k = 0; k < 4; ++k) {
+        size_t offset = random() % expected.size();
+        PmSet::const_iterator it = set->begin();
+        it += std::ptrdiff_t(offset);
+        CHECK(it.rank() == expected[offset]);
+        CHECK(size_t(it - set->begin()) == offset);
+        CHECK(size_t(set->end() - it) == expected.size() - offset);
+    }
+
+    CHECK(set->contains(universe.at(expected[expected.size() / 2])));
+    vector<PmRank> sorted(expected);
+    if (!std::is_sorted(sorted.begin(), sorted.end())) {
+        std::sort(sorted.begin(), sorted.end());
+    }
+    for (int k = 0; k < NUM_PROBES; ++k) {
+        PmRank probe = PmRank(random() % NUM_PERMS);
+        CHECK(set->contains(universe.at(probe)) ==
+              std::binary_search(sorted.begin(), sorted.end(), probe));
+    }
+
+    PmSet copy(set->begin(), set->end());
+    CHECK(copy.size() == expected.size());
+    CHECK(copy.hash() == hashRanks(expected));
+
+    PmSet** chunks = set->copyIntoChunks(NUM_CHUNKS);
+    size_t numInChunks = 0;
+    bool isChunkInOrder = true;
+    for (int c = 0; c < NUM_CHUNKS; ++c) {
+        for (PmSet::const_iterator it = chunks[c]->begin(); it != chunks[c]->end(); ++it) {
+            isChunkInOrder = isChunkInOrder && numInChunks < expected.size() &&
+                    it.rank() == expected[numInChunks];
+            ++numInChunks;
+        }
+        delete chunks[c];
+    }
+    delete[] chunks;
+    CHECK(isChunkInOrder);
+    CHECK(numInChunks == expected.size());
+}
+
+static void filterExpected(vector<PmRank>* expected, const TruthBooth& tb, bool isMatch) {
+    const PerfectMatchingUniverse& universe = PerfectMatchingUniverse::get();
+    vector<PmRank> retained;
+    for (vector<PmRank>::const_iterator it = expected->begin(); it != expected->end(); ++it) {
+        if (tb.isContainedIn(universe.at(*it)) == isMatch) {
+            retained.push_back(*it);
+        }
+    }
+    expected->swap(retained);
+}
+
+static void filterExpected(vector<PmRank>* expected, const Pm& guess, int numCorrect) {
+    const PerfectMatchingUniverse& universe = PerfectMatchingUniverse::get();
+    vector<PmRank> retained;
+    for (vector<PmRank>::const_iterator it = expected->begin(); it != expected->end(); ++it) {
+        if (numInCommon(guess, universe.at(*it)) == numCorrect) {
+            retained.push_back(*it);
+        }
+    }
+    expected->swap(retained);
+}
+
+static vector<PmRank> getAllRanks() {
+    vector<PmRank> ranks(NUM_PERMS);
+    for (PmRank r = 0; r < NUM_PERMS; ++r) {
+        ranks[r] = r;
+    }
+    return ranks;
+}
+
+// Largest rank not in the set, after all of its ranks unless it has the last.
+static PmRank getRankToAdd(const vector<PmRank>& expected) {
+    PmRank rank = NUM_PERMS - 1;
+    while (std::find(expected.begin(), expected.end(), rank) != expected.end()) {
+        --rank;
+    }
+    return rank;
+}
+
+// Walk one set through every layout in turn, checking it at each.
+static void testLayouts(ScratchArena* arena, std::mt19937& random) {
+    const PerfectMatchingUniverse& universe = PerfectMatchingUniverse::get();
+    PmSet* set = arena ? new PmSet(arena) : new PmSet();
+    set->populateAll();
+    vector<PmRank> expected = getAllRanks();
+
+    // A Truth Booth leaves a tenth of the universe: a bitset.
+    TruthBooth tb(3, '7');
+    set->filter(tb, true);
+    filterExpected(&expected, tb, true);
+    CHECK(expected.size() >= DENSE_SET_MIN_SIZE);
+    CHECK(set->begin().isOverBitset());
+    checkSame(set, expected, random);
+
+    // One correct out of ten leaves too few for a bitset: ranks.
+    Pm guess = universe.at(PmRank(random() % NUM_PERMS));
+    set->filter(guess, 3);
+    filterExpected(&expected, guess, 3);
+    CHECK(expected.size() < DENSE_SET_MIN_SIZE && expected.size() > PACKED_SET_MAX_SIZE);
+    CHECK(!set->begin().isOverBitset());
+    checkSame(set, expected, random);
+
+    // Narrow down to the end game: packed matchings.
+    while (expected.size() > PACKED_SET_MAX_SIZE) {
+        Pm next = universe.at(expected[random() % expected.size()]);
+        int numCorrect = numInCommon(next, universe.at(expected[random() % expected.size()]));
+        set->filter(next, numCorrect);
+        filterExpected(&expected, next, numCorrect);
+    }
+    checkSame(set, expected, random);
+
+    // Adding to a packed set, e.g. a guess to the guesses made, drops the
+    // packed matchings; the next filter packs the set again.
+    PmRank added = getRankToAdd(expected);
+    set->addRank(added);
+    expected.push_back(added);
+    checkSame(set, expected, random);
+    TruthBooth other(universe.at(added)[0] == '0' ? 1 : 0, universe.at(added)[0]);
+    set->filter(other, false);
+    filterExpected(&expected, other, false);
+    checkSame(set, expected, random);
+    added = getRankToAdd(expected);
+    set->add(universe.at(added));
+    expected.push_back(added);
+    checkSame(set, expected, random);
+
+    delete set;
+}
+
+// Random filters, checked against the brute force after each.
+static void testRandomGame(ScratchArena* arena, std::mt19937& random) {
+    const PerfectMatchingUniverse& universe = PerfectMatchingUniverse::get();
+    PmSet* set = arena ? new PmSet(arena) : new PmSet();
+    set->populateAll();
+    vector<PmRank> expected = getAllRanks();
+
+    for (int step = 0; step < NUM_STEPS && expected.size() > 1; ++step) {
+        const Pm& answer = universe.at(expected[random() % expected.size()]);
+        if (random() % 2) {
+            TruthBooth tb(int(random() % PERM_LENGTH), char('0' + random() % PERM_LENGTH));
+            bool isMatch = tb.isContainedIn(answer);
+            set->filter(tb, isMatch);
+            filterExpected(&expected, tb, isMatch);
+        } else {
+            Pm guess = universe.at(PmRank(random() % NUM_PERMS));
+            int numCorrect = numInCommon(guess, answer);
+            set->filter(guess, numCorrect);
+            filterExpected(&expected, guess, numCorrect);
+        }
+        checkSame(set, expected, random);
+    }
+
+    PmRank added = getRankToAdd(expected);
+    set->addRank(added);
+    expected.push_back(added);
+    checkSame(set, expected, random);
+    delete set;
+}
+
+int main() {
+    std::mt19937 random(3);
+    ScratchArena arena(16 << 20);
+
+    testLayouts(nullptr, random);
+    arena.reset();
+    testLayouts(&arena, random);
+    for (int game = 0; game < NUM_GAMES; ++game) {
+        arena.reset();
+        testRandomGame(game % 2 ? &arena : nullptr, random);
+    }
+
+    if (numFailures > 0) {
+        printf("PerfectMatchingSetTest: %d checks failed.\n", numFailures);
+        return 1;
+    }
+    printf("PerfectMatchingSetTest: ok.\n");
+    return 0;
+}
@@ -0,0 +1,98 @@
+/**
+ * SolverSessionTest.cpp
+ * Christopher Chute
+ *
+ * Play one season through a SolverSession, applying its own suggestions, and
+ * check that it finds the answer as ./ayto does; check that feedback which
+ * contradicts itself leaves no suggestions, and that a session naming
+ * another pool file than the one already read fails. Run with 'make test'.
+ */
+
+#include <cstdio>
+#include <stdexcept>
+#include "SolverSession.h"
+
+#define TEST_POOL_FILENAME ("../scripts/pool.txt") // Tests run from src.
+#define TEST_ANSWER ("1302547869")                 // Found in 9 weeks by ./ayto.
+#define MAX_WEEKS (12)                             // Weeks before giving up.
+
+#define CHECK(condition) checkThat((condition), #condition, __FILE__, __LINE__)
+
+typedef PerfectMatching Pm;
+typedef TruthBooth Tb;
+
+static int numFailures = 0;
+
+static void checkThat(bool isTrue, const char* condition, const char* file, int line) {
+    if (!isTrue) {
+        printf("%s:%d: failed: %s\n", file, line, condition);
+        ++numFailures;
+    }
+}
+
+// Take every suggestion, with the feedback the answer gives, until it is found.
+static void testSeason() {
+    SolverOptions options;
+    options._poolFilename = TEST_POOL_FILENAME;
+    SolverSession session(options);
+    CHECK(session.remaining() == NUM_PERMS);
+
+    Pm answer(TEST_ANSWER);
+    int numWeeks = 0;
+    bool isFound = false;
+    while (!isFound && numWeeks < MAX_WEEKS) {
+        ++numWeeks;
+        Tb tb = session.nextTruthBooth();
+        CHECK(session.applyTruthBooth(tb, tb.isContainedIn(answer)));
+        Pm guess = session.nextPerfectMatching();
+        CHECK(isPerfectMatching(guess));
+        int numCorrect = numInCommon(guess, answer);
+        CHECK(session.applyPerfectMatching(guess, numCorrect));
+        CHECK(session.getPossibleAnswers()->contains(answer));
+        isFound = numCorrect == PERM_LENGTH;
+    }
+    CHECK(isFound);
+    CHECK(session.remaining() == 1);
+    printf("SolverSessionTest: found %s in %d weeks.\n", TEST_ANSWER, numWeeks);
+}
+
+// Feedback no answer agrees with leaves nothing to suggest.
+static void testContradiction() {
+    SolverOptions options;
+    options._poolFilename = TEST_POOL_FILENAME;
+    SolverSession session(options);
+    CHECK(session.applyPerfectMatching(DIGITS, PERM_LENGTH));
+    CHECK(session.applyPerfectMatching(DIGITS, 0));
+    CHECK(session.remaining() == 0);
+    Tb tb = session.nextTruthBooth();
+    CHECK(tb.index == -1 && tb.charAtIndex == '_');
+    CHECK(session.nextPerfectMatching() == "");
+    CHECK(!session.applyPerfectMatching("0123", 1));
+    CHECK(!session.applyTruthBooth(Tb(PERM_LENGTH, '0'), true));
+}
+
+// The pool is read once per process, so another file cannot be used.
+static void testOtherPool() {
+    SolverOptions options;
+    options._poolFilename = "no-such-pool.txt";
+    bool isThrown = false;
+    try {
+        SolverSession session(options);
+    } catch (const std::runtime_error&) {
+        isThrown = true;
+    }
+    CHECK(isThrown);
+}
+
+int main() {
+    testSeason();
+    testContradiction();
+    testOtherPool();
+
+    if (numFailures > 0) {
+        printf("SolverSessionTest: %d checks failed.\n", numFailures);
+        return 1;
+    }
+    printf("SolverSessionTest: ok.\n");
+    return 0;
+}